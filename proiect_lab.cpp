@@ -10,945 +10,7252 @@
 #include <limits>
 #include <iomanip>
 #include <unordered_map>
+#include <map>
 #include <functional>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstddef>
+#include <cerrno>
+#include <csignal>
+#include <iterator>
+#include <deque>
+#include <numeric>
+#include <charconv>
+#include <string_view>
+#include <thread>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <optional>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 class Step;
 class ProcessBuilder;
+class OutputPipeline;
 
-// enumeration class for all the operations used in calculus step
-enum class OperationType
+// what a step does when its flow goes over the memory budget: keep going without holding its input in
+// memory (streaming) or stop with a MemoryBudgetExceeded error
+enum class MemoryBudgetPolicy
 {
-    Addition,
-    Substraction,
-    Multiplication,
-    Division,
-    Minimum,
-    Maximum
+    Stream,
+    FailFast
 };
 
-class Step
+class MemoryBudgetExceeded : public std::runtime_error
 {
 public:
-    // declaratie functie virtuala pura care sa fie executata in clasele derivate
-    virtual void execute() = 0;
-    virtual std::string getType() const = 0;
-    // functie virtuala cu implementare implicita. Returneaza true dar poate fi suprascrisa in clasele derivate
-    virtual bool userInteraction()
-    {
-        return true;
-    }
-    // functie virtuala cu implementare implicita
-    virtual void displayDescription() const
-    {
-        std::cout << "No description available for this step" << std::endl;
-    }
-    virtual ~Step() = default;
+    explicit MemoryBudgetExceeded(const std::string &message) : std::runtime_error(message) {}
 };
 
-class TitleStep : public Step
+// bytes allocated on behalf of a flow or a step. The allocations made while an account is current (see
+// MemoryAccountScope) are charged to it and to its parents and credited back when they are freed, from
+// any thread; the workers of a step make the account of the step current, so their allocations count too.
+// Accounts are never destroyed, not even at exit: memory may outlive the flow that allocated it, and static
+// objects destroyed late (e.g. the trace buffers) still free blocks charged to them
+class MemoryAccount
 {
 private:
-    std::string title;
-    std::string subtitle;
+    std::string name;
+    MemoryAccount *parent;
+    std::atomic<int64_t> currentBytes{0};
+    std::atomic<int64_t> peakBytes{0};
+    std::atomic<uint64_t> allocationCount{0}; // calls of operator new charged so far, never decreases
+    size_t budget = 0; // 0 means no budget
+    MemoryBudgetPolicy policy = MemoryBudgetPolicy::Stream;
+
+    static inline thread_local MemoryAccount *current = nullptr;
+
+    friend class MemoryAccountScope;
 
 public:
-    // constructor for title step
-    TitleStep(const std::string &title, const std::string &subtitle) : title(title), subtitle(subtitle) {}
+    // use create, the constructor is only public for the registry
+    MemoryAccount(const std::string &name, MemoryAccount *parent) : name(name), parent(parent) {}
 
-    void execute() override
+    static MemoryAccount *create(const std::string &name, MemoryAccount *parent = nullptr)
     {
-        std::cout << "Title: " << title << "\nSubtitle: " << subtitle << "\n";
+        // leaked on purpose, so the accounts stay valid during the destruction of the static objects
+        static std::mutex *registryMutex = new std::mutex;
+        static std::deque<MemoryAccount> *registry = new std::deque<MemoryAccount>;
+        std::lock_guard<std::mutex> lock(*registryMutex);
+        return &registry->emplace_back(name, parent);
     }
 
-    std::string getType() const override
+    static MemoryAccount *getCurrent()
     {
-        return "TITLE";
+        return current;
     }
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    void charge(size_t bytes)
     {
-        // add logic for user interaction specific to title step
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        for (MemoryAccount *account = this; account; account = account->parent)
+        {
+            account->allocationCount.fetch_add(1, std::memory_order_relaxed);
+            int64_t now = account->currentBytes.fetch_add(bytes, std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+            int64_t peak = account->peakBytes.load(std::memory_order_relaxed);
+            while (now > peak && !account->peakBytes.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+            {
+            }
+        }
     }
 
-    void displayDescription() const override
+    void release(size_t bytes)
     {
-        std::cout << "This step displays a title and a subtitle" << std::endl;
+        for (MemoryAccount *account = this; account; account = account->parent)
+        {
+            account->currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        }
     }
-};
-
-class TextStep : public Step
-{
-private:
-    std::string title;
-    std::string copy;
-
-public:
-    // constructor for text step
-    TextStep(const std::string &title, const std::string &copy) : title(title), copy(copy) {}
 
-    void execute() override
+    void setBudget(size_t bytes, MemoryBudgetPolicy budgetPolicy)
     {
-        std::cout << "Title: " << title << "\nCopy: " << copy << "\n";
+        budget = bytes;
+        policy = budgetPolicy;
     }
 
-    std::string getType() const override
+    // the first account from the current one up to its root that is over its budget, nullptr if none
+    static MemoryAccount *exceededBudget()
     {
-        return "TEXT";
+        for (MemoryAccount *account = current; account; account = account->parent)
+        {
+            if (account->budget > 0 && account->getCurrentBytes() > account->budget)
+            {
+                return account;
+            }
+        }
+        return nullptr;
     }
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    std::string budgetMessage() const
     {
-        // add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        return "memory budget of " + std::to_string(budget) + " bytes exceeded by '" + name + "'";
     }
 
-    void displayDescription() const override
+    const std::string &getName() const
     {
-        std::cout << "This step displays a title and a copy" << std::endl;
+        return name;
     }
-};
 
-class TextInputStep : public Step
-{
-private:
-    std::string textInput;
-    std::string description;
-
-public:
-    // constructor fot text input step
-    TextInputStep(const std::string &description) : description(description) {}
-
-    void execute() override
+    size_t getCurrentBytes() const
     {
-        std::cout << "Description: " << description << std::endl;
-        std::cout << "Enter text: ";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        std::getline(std::cin, textInput);
+        return static_cast<size_t>(std::max<int64_t>(0, currentBytes.load(std::memory_order_relaxed)));
     }
 
-    std::string getType() const override
+    size_t getPeakBytes() const
     {
-        return "TEXT INPUT";
+        return static_cast<size_t>(peakBytes.load(std::memory_order_relaxed));
     }
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    // comparing two readings shows whether the code run in between allocates, e.g. that a repeated run of
+    // a flow reuses the memory of the previous one
+    uint64_t getAllocationCount() const
     {
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        return allocationCount.load(std::memory_order_relaxed);
     }
 
-    void displayDescription() const override
+    size_t getBudget() const
     {
-        std::cout << "This step displays a text and a description" << std::endl;
+        return budget;
     }
 
-    std::string getTextInput() const
+    MemoryBudgetPolicy getPolicy() const
     {
-        return textInput;
+        return policy;
     }
 };
 
-class CSVInputStep : public Step
+// makes an account current for the calling thread until the end of the scope
+class MemoryAccountScope
 {
 private:
-    std::string description;
-    std::string CSVInput;
-    std::string fileName;
+    MemoryAccount *previous;
 
 public:
-    // constructor for csv input step
-    CSVInputStep(const std::string &description) : description(description) {}
+    explicit MemoryAccountScope(MemoryAccount *account) : previous(MemoryAccount::current)
+    {
+        MemoryAccount::current = account;
+    }
 
-    void execute() override
+    ~MemoryAccountScope()
     {
-        std::cout << "Description: " << description << std::endl;
-        std::cout << "Enter CSV data: ";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer (previne consumul neasteptat al unor caractere ramase in buffer dupa citirea valorilor)
-        std::getline(std::cin, CSVInput);
+        MemoryAccount::current = previous;
+    }
 
-        std::cout << "Enter the filename to save the CSV data: ";
-        std::getline(std::cin, fileName);
+    MemoryAccountScope(const MemoryAccountScope &) = delete;
+    MemoryAccountScope &operator=(const MemoryAccountScope &) = delete;
+};
 
-        // save CSV data to the file
-        saveCsvToFile();
-    }
+// what a run does after one of its steps ran past its deadline
+enum class TimeoutPolicy
+{
+    Continue, // the step counts as an error and the run moves on to the next step
+    Abort     // the run stops there
+};
 
-    std::string getType() const override
+// thrown by the cancellation checks of a step that ran past its deadline or past the deadline of its flow
+class StepTimeout : public std::runtime_error
+{
+private:
+    bool flowDeadline;
+
+public:
+    StepTimeout(const std::string &message, bool flowDeadline) : std::runtime_error(message), flowDeadline(flowDeadline) {}
+
+    bool isFlowDeadline() const
     {
-        return "CSV INPUT";
+        return flowDeadline;
     }
+};
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+// deadlines of the running step and of its flow, checked cooperatively by the long-running loops of the
+// steps (line, row, page and write loops). The loops reach the token of their thread through the static
+// functions; without a current token they never stop
+class CancellationToken
+{
+private:
+    std::chrono::steady_clock::time_point stepDeadline;
+    std::chrono::steady_clock::time_point flowDeadline;
+    std::atomic<bool> cancelled{false}; // sticky once a check has seen a deadline pass
+    std::atomic<bool> flowExpired{false};
+
+    static const unsigned POLL_INTERVAL = 256; // the polling checks read the clock once every POLL_INTERVAL calls
+    static inline thread_local unsigned pollCount = 0;
+
+    bool expired()
     {
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        if (cancelled.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= flowDeadline)
+        {
+            flowExpired.store(true, std::memory_order_relaxed);
+        }
+        if (now >= stepDeadline || now >= flowDeadline)
+        {
+            cancelled.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
     }
 
-    void displayDescription() const override
+public:
+    static inline thread_local CancellationToken *current = nullptr;
+
+    CancellationToken(std::chrono::steady_clock::time_point stepDeadline, std::chrono::steady_clock::time_point flowDeadline) : stepDeadline(stepDeadline), flowDeadline(flowDeadline) {}
+
+    CancellationToken(const CancellationToken &) = delete;
+    CancellationToken &operator=(const CancellationToken &) = delete;
+
+    StepTimeout timeout() const
     {
-        std::cout << "Expected input: " << description << std::endl;
+        bool flow = flowExpired.load(std::memory_order_relaxed);
+        return StepTimeout(flow ? "the deadline of the flow passed" : "the deadline of the step passed", flow);
     }
 
-    // returneaza datele csv introduse de utilizator
-    std::string getCSVInput() const
+    // for loops that run often: true once the step must stop, reading the clock only now and then
+    static bool stopRequested()
     {
-        return CSVInput;
+        CancellationToken *token = current;
+        return token && (token->cancelled.load(std::memory_order_relaxed) || (++pollCount % POLL_INTERVAL == 0 && token->expired()));
     }
 
-    // returneaza numele fisierului dat de utilizator
-    std::string getFileName() const
+    // reads the clock: true when the step must stop
+    static bool stopped()
     {
-        return fileName;
+        return current && current->expired();
     }
 
-    // function to save csv data to the specified files
-    void saveCsvToFile() const
+    // throwing forms of stopRequested and stopped, for loops that can stop anywhere
+    static void checkpoint()
     {
-        std::ofstream outputFile(fileName);
-        if (outputFile.is_open())
+        if (stopRequested())
         {
-            outputFile << CSVInput;
-            outputFile.close();
-            std::cout << "CSV data saved to file: " << fileName << std::endl;
+            throw current->timeout();
         }
-        else
+    }
+
+    static void check()
+    {
+        if (stopped())
         {
-            std::cerr << "Error: Unable to save CSV data to file '" << fileName << "'." << std::endl;
+            throw current->timeout();
         }
     }
 };
 
-class NumberInputStep : public Step
+// makes a token current for the calling thread until the end of the scope
+class CancellationScope
 {
 private:
-    std::string description;
-    float numberInput;
+    CancellationToken *previous;
 
 public:
-    // constructor for number input step
-    NumberInputStep(const std::string &description) : description(description) {}
+    explicit CancellationScope(CancellationToken *token) : previous(CancellationToken::current)
+    {
+        CancellationToken::current = token;
+    }
 
-    void execute() override
+    ~CancellationScope()
     {
-        std::cout << "Description: " << description << std::endl;
-        std::cout << "Enter a number: ";
-        std::cin >> numberInput;
+        CancellationToken::current = previous;
+    }
 
-        // if the reading doesn't work
-        if (std::cin.fail())
+    CancellationScope(const CancellationScope &) = delete;
+    CancellationScope &operator=(const CancellationScope &) = delete;
+};
+
+// the replacements stay out of line, otherwise GCC pairs the inlined free with the new expression and warns
+#if defined(__GNUC__)
+#define FLOW_NOINLINE __attribute__((noinline))
+#else
+#define FLOW_NOINLINE
+#endif
+
+// every block starts with the account it was charged to, so it is credited back wherever it is freed
+struct alignas(std::max_align_t) AllocationHeader
+{
+    MemoryAccount *account;
+    size_t size;
+};
+
+FLOW_NOINLINE void *operator new(std::size_t size)
+{
+    if (size > SIZE_MAX - sizeof(AllocationHeader))
+    {
+        throw std::bad_alloc();
+    }
+    void *block;
+    // like the standard operator new: call the new handler until the allocation succeeds or there is none
+    while (!(block = std::malloc(sizeof(AllocationHeader) + size)))
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
         {
-            std::cin.clear(); // resetarea starii obiectului std::cin
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            throw std::invalid_argument("Invalid input. Please enter a valid number.");
+            throw std::bad_alloc();
         }
-
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        handler();
     }
-
-    std::string getType() const override
+    AllocationHeader *header = static_cast<AllocationHeader *>(block);
+    header->account = MemoryAccount::getCurrent();
+    header->size = size;
+    if (header->account)
     {
-        return "NUMBER INPUT";
+        header->account->charge(size);
     }
+    return header + 1;
+}
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+FLOW_NOINLINE void operator delete(void *memory) noexcept
+{
+    if (!memory)
     {
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        return;
     }
-
-    void displayDescription() const override
+    AllocationHeader *header = static_cast<AllocationHeader *>(memory) - 1;
+    if (header->account)
     {
-        std::cout << "This step displays a description and a number" << std::endl;
+        header->account->release(header->size);
     }
+    std::free(header);
+}
 
-    float getNumberInput() const
+FLOW_NOINLINE void operator delete(void *memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+// the other forms go through the two above, so every block has its header
+FLOW_NOINLINE void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+FLOW_NOINLINE void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
     {
-        return numberInput;
+        return operator new(size);
     }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+FLOW_NOINLINE void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+FLOW_NOINLINE void operator delete[](void *memory) noexcept
+{
+    operator delete(memory);
+}
+
+FLOW_NOINLINE void operator delete[](void *memory, std::size_t) noexcept
+{
+    operator delete(memory);
+}
+
+FLOW_NOINLINE void operator delete(void *memory, const std::nothrow_t &) noexcept
+{
+    operator delete(memory);
+}
+
+FLOW_NOINLINE void operator delete[](void *memory, const std::nothrow_t &) noexcept
+{
+    operator delete(memory);
+}
+
+// enumeration class for all the operations used in calculus step
+enum class OperationType
+{
+    Addition,
+    Substraction,
+    Multiplication,
+    Division,
+    Minimum,
+    Maximum
 };
 
-class CalculusStep : public Step
+// single producer / single consumer lock-free ring buffer with a power of two capacity
+template <typename T, size_t Capacity>
+class SpscRingBuffer
 {
 private:
-    // set a vector to the previous steps to be able to effectuate the operations on them
-    std::vector<NumberInputStep *> previousSteps; // vector de pasi anteriori
-    std::vector<char> operations;                 // vector de operatii matematice
-    float result;
-    OperationType operationType; // alegem tipul de operatie matematica
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
 
-public:
-    // constructor fot calculus step
-    CalculusStep(const std::vector<NumberInputStep *> &steps, const std::vector<char> &ops, OperationType opType) : previousSteps(steps), operations(ops), result(0.0f), operationType(opType) {}
+    std::array<T, Capacity> items;
+    alignas(64) std::atomic<size_t> head{0}; // next slot to write, owned by the producer
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to read, owned by the consumer
 
-    // afiseaza expresia si implementeaza operatia matematica
-    void execute() override
+public:
+    // returns false when the buffer is full, the item is not stored
+    bool push(const T &item)
     {
-        std::cout << "Expression: ";
-        for (size_t i = 0; i < previousSteps.size(); ++i)
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead - tail.load(std::memory_order_acquire) == Capacity)
         {
-            std::cout << "Step: " << i + 1;
-            if (i < operations.size())
-            {
-                std::cout << " " << operations[i] << " ";
-            }
+            return false;
         }
-        std::cout << std::endl;
-
-        // perform the operation
-        result = previousSteps[0]->getNumberInput();
+        items[currentHead & (Capacity - 1)] = item;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
 
-        for (size_t i = 0; i < operations.size(); ++i)
+    // returns false when the buffer is empty
+    bool pop(T &item)
+    {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail == head.load(std::memory_order_acquire))
         {
-            float operand = previousSteps[i + 1]->getNumberInput();
-
-            switch (operationType)
-            {
-            case OperationType::Addition:
-                result += operand;
-                break;
-            case OperationType::Substraction:
-                result -= operand;
-                break;
-            case OperationType::Multiplication:
-                result *= operand;
-                break;
-            case OperationType::Division:
-                if (operand != 0)
-                {
-                    result /= operand;
-                }
-                else
-                {
-                    std::cerr << "Error!! Division by 0!" << std::endl;
-                }
-                break;
-            case OperationType::Minimum:
-                result = std::min(result, operand);
-                break;
-            case OperationType::Maximum:
-                result = std::max(result, operand);
-                break;
-            default:
-                std::cerr << "Invalid operation: " << operations[i] << std::endl;
-                break;
-            }
+            return false;
         }
-        std::cout << "Result: " << result << std::endl;
+        item = items[currentTail & (Capacity - 1)];
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
     }
+};
 
-    std::string getType() const override
-    {
-        return "CALCULUS";
-    }
+// multiple producer / single consumer lock-free bounded ring buffer (every slot carries a sequence number
+// telling whether it is free for the producer of a lap or filled for the consumer)
+template <typename T, size_t Capacity>
+class MpscRingBuffer
+{
+private:
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    struct Slot
     {
-        // add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
-    }
+        std::atomic<size_t> sequence;
+        T item;
+    };
 
-    void displayDescription() const override
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> head{0}; // next position claimed by a producer
+    alignas(64) size_t tail = 0;            // next position read by the consumer
+
+public:
+    MpscRingBuffer() : slots(new Slot[Capacity])
     {
-        std::cout << "This step displays the number of steps, the operation and the operands" << std::endl;
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
     }
 
-    float getResult() const
+    // returns false when the buffer is full, the item is not stored
+    bool push(T item)
     {
-        return result;
+        size_t position = head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = slots[position & (Capacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position)
+            {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.item = std::move(item);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position)
+            {
+                return false;
+            }
+            else
+            {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
     }
 
-    // destructor care elibereaza memoria ocupata de pasii anteriori
-    ~CalculusStep()
+    // only called by the consumer thread; returns false when the buffer is empty
+    bool pop(T &item)
     {
-        for (NumberInputStep *step : previousSteps)
+        Slot &slot = slots[tail & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1)
         {
-            delete step;
+            return false;
         }
+        item = std::move(slot.item);
+        slot.sequence.store(tail + Capacity, std::memory_order_release);
+        tail++;
+        return true;
     }
 };
 
-class DisplayStep : public Step
+// one begin/end record of the trace
+struct TraceEvent
 {
-private:
-    // pointer to the previous step to be able to take the informations from them
-    Step *previousStep;
+    char name[64];
+    const char *category; // always a string literal
+    char phase;           // 'B' for begin, 'E' for end
+    uint64_t timestamp;   // microseconds since tracing was enabled
+};
 
-public:
-    DisplayStep(Step *prevStep) : previousStep(prevStep) {}
+// records step executions, file operations and user waits into per-thread ring buffers and
+// writes them as Chrome trace-event JSON (open the file in Perfetto or chrome://tracing).
+// When tracing is disabled the only cost is one relaxed atomic load per scope.
+class Tracer
+{
+private:
+    struct ThreadBuffer
+    {
+        uint32_t threadId;
+        std::atomic<uint64_t> dropped{0};
+        SpscRingBuffer<TraceEvent, 32768> events;
+    };
+
+    static inline std::atomic<bool> enabled{false};
+    static inline std::chrono::steady_clock::time_point epoch;
+    static inline std::mutex registryMutex;
+    static inline std::vector<std::unique_ptr<ThreadBuffer>> buffers; // one buffer for every thread that traced something
+    static inline std::vector<std::pair<uint32_t, TraceEvent>> collected; // events already drained from the buffers
+
+    static ThreadBuffer &localBuffer()
+    {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffers.back()->threadId = static_cast<uint32_t>(buffers.size());
+            buffer = buffers.back().get();
+        }
+        return *buffer;
+    }
 
-    void execute() override
+    static void writeEscaped(std::ostream &out, const char *text)
     {
-        std::cout << "Displaying information from the previous step:... " << std::endl;
-        // verifica tipul pasului anterior si afiseaza informatiile corespunzatoare
-        if (previousStep->getType() == "TEXT INPUT")
+        for (; *text; ++text)
         {
-            TextInputStep *textInputStep = dynamic_cast<TextInputStep *>(previousStep); // folosim dynamic_cast pentru a incerca sa convertim pointerul previousStep la un pointer de tipul TextInputStep
-            if (textInputStep)
+            if (*text == '"' || *text == '\\')
             {
-                std::cout << "Text Input Content: " << textInputStep->getTextInput() << std::endl;
+                out << '\\';
             }
-        }
-        else if (previousStep->getType() == "CSV INPUT")
-        {
-            CSVInputStep *csvInputStep = dynamic_cast<CSVInputStep *>(previousStep);
-            if (csvInputStep)
+            if (static_cast<unsigned char>(*text) >= 0x20)
             {
-                std::string fileName = csvInputStep->getFileName();
-                displayFileContent(fileName);
+                out << *text;
             }
         }
-        else
-        {
-            std::cout << "Cannot display information. Previous step type not supported" << std::endl;
-        }
     }
 
-    std::string getType() const override
+public:
+    static void enable()
     {
-        return "DISPLAY";
+        epoch = std::chrono::steady_clock::now();
+        enabled.store(true, std::memory_order_release);
     }
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    static bool isEnabled()
     {
-        // add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        return enabled.load(std::memory_order_relaxed);
     }
 
-    // function to display the informations from the file
-    void displayFileContent(const std::string &fileName) const
+    // the name is the concatenation of prefix and detail, truncated to fit the event
+    static void record(const char *category, char phase, const char *prefix, const char *detail = "")
     {
-        std::ifstream file(fileName);
-        if (file.is_open())
+        TraceEvent event;
+        size_t prefixLength = std::min(strlen(prefix), sizeof(event.name) - 1);
+        size_t detailLength = std::min(strlen(detail), sizeof(event.name) - 1 - prefixLength);
+        memcpy(event.name, prefix, prefixLength);
+        memcpy(event.name + prefixLength, detail, detailLength);
+        event.name[prefixLength + detailLength] = '\0';
+        event.category = category;
+        event.phase = phase;
+        event.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count());
+
+        ThreadBuffer &buffer = localBuffer();
+        if (!buffer.events.push(event))
         {
-            // cream un obiect buffer pentru a stoca continutul fisierului
-            std::stringstream buffer;
-            // citim intregul continut al fisierului in buffer
-            buffer << file.rdbuf();
-            std::cout << "File Content:" << std::endl
-                      << buffer.str() << std::endl;
-            file.close();
-        }
-        else
-        {
-            std::cout << "Error: Unable to open file '" << fileName << "'." << std::endl;
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
-    void displayDescription() const override
+    // drains every thread buffer and (re)writes the whole trace collected so far to the file
+    static bool flush(const std::string &fileName)
     {
-        std::cout << "This step displays informations about the other steps" << std::endl;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        uint64_t dropped = 0;
+        for (const auto &buffer : buffers)
+        {
+            TraceEvent event;
+            while (buffer->events.pop(event))
+            {
+                collected.emplace_back(buffer->threadId, event);
+            }
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+        }
+
+        std::ofstream traceFile(fileName);
+        if (!traceFile.is_open())
+        {
+            std::cerr << "Error: Unable to write trace file '" << fileName << "'." << std::endl;
+            return false;
+        }
+        traceFile << "{\"traceEvents\":[";
+        for (size_t i = 0; i < collected.size(); ++i)
+        {
+            const TraceEvent &event = collected[i].second;
+            traceFile << (i ? ",\n" : "\n") << "{\"name\":\"";
+            writeEscaped(traceFile, event.name);
+            traceFile << "\",\"cat\":\"" << event.category << "\",\"ph\":\"" << event.phase
+                      << "\",\"ts\":" << event.timestamp << ",\"pid\":1,\"tid\":" << collected[i].first << "}";
+        }
+        traceFile << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+
+        if (dropped > 0)
+        {
+            std::cerr << "Warning: " << dropped << " trace events were dropped (ring buffer full)." << std::endl;
+        }
+        return true;
     }
 };
 
-class TextFileInputStep : public Step
+// records a begin event on construction and the matching end event on destruction
+class TraceScope
 {
 private:
-    std::string description;
-    std::string fileName;
-    std::string fileContent; // continutul citit din fisier
+    const char *category;
+    bool active;
 
 public:
-    // constructor for text file input step
-    TextFileInputStep(const std::string &description, const std::string &file_name) : description(description), fileName(fileName) {}
-
-    void execute() override
+    TraceScope(const char *category, const char *name, const char *detail = "") : category(category), active(Tracer::isEnabled())
     {
-        std::cout << "Description: " << description << "\nFile name: " << fileName << std::endl;
-        std::ifstream inputFile(fileName);
-
-        // check if the file is open
-        if (inputFile.is_open())
-        {
-            // read the content from the file linie cu linie si adauga la continutul total al fisierului
-            std::string line;
-            while (std::getline(inputFile, line))
-            {
-                fileContent += line + '\n';
-            }
-            std::cout << "File content: \n"
-                      << fileContent << std::endl;
-            // close the file
-            inputFile.close();
-        }
-        else
+        if (active)
         {
-            std::cerr << "Unable to open the file: " << fileName << std::endl;
+            Tracer::record(category, 'B', name, detail);
         }
     }
 
-    std::string getType() const override
-    {
-        return "TEXT FILE INPUT";
-    }
+    TraceScope(const char *category, const char *name, const std::string &detail) : TraceScope(category, name, detail.c_str()) {}
 
-    // function used to see if the user wants to skip to the next step
-    bool userInteraction() override
+    TraceScope(const char *category, const std::string &name) : TraceScope(category, name.c_str()) {}
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    ~TraceScope()
     {
-        // Add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        if (active)
+        {
+            Tracer::record(category, 'E', "");
+        }
     }
+};
 
-    void displayDescription() const override
+// hardware counter values of one or more step executions
+struct PerfCounterValues
+{
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t branchMisses = 0;
+
+    PerfCounterValues &operator+=(const PerfCounterValues &other)
     {
-        std::cout << "This step displays a description and the name of the file" << std::endl;
+        cycles += other.cycles;
+        instructions += other.instructions;
+        cacheMisses += other.cacheMisses;
+        branchMisses += other.branchMisses;
+        return *this;
     }
 };
 
-class CSVFileInputStep : public Step
+// hardware performance counters of the thread running the steps and of the threads it starts (the ingestion
+// and aggregate workers), read with perf_event_open on Linux. The four events form one group, so they are
+// scheduled on the PMU together, and are scaled by the share of the time they were running when the kernel
+// multiplexes them with other events. In containers, VMs without a virtual PMU or with a strict
+// perf_event_paranoid the counters cannot be opened; they then report themselves unavailable and every
+// read returns zeros.
+class PerfCounters
 {
 private:
-    std::string description;
-    std::string file_name;
-    std::vector<std::vector<std::string>> csvData;
+    static constexpr int COUNTER_COUNT = 4;
+    int fds[COUNTER_COUNT]; // cycles (the group leader), instructions, cache misses, branch misses
+    std::thread::id owner;  // counters with pid 0 follow the thread that opened them
 
-public:
-    // constructor for csv file input step
-    CSVFileInputStep(const std::string &description, const std::string &file_name) : description(description), file_name(file_name) {}
+#ifdef __linux__
+    static int openCounter(uint64_t config, int groupFd)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = groupFd < 0 ? 1 : 0; // the members follow the leader
+        attr.inherit = 1;                     // threads started after the open are counted too
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+#endif
 
-    void execute() override
+    void open()
     {
-        std::cout << "Description: " << description << "\nFile name: " << file_name << std::endl;
-        std::ifstream inputFile(file_name);
+#ifdef __linux__
+        const uint64_t configs[COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        fds[0] = openCounter(configs[0], -1);
+        for (int i = 1; i < COUNTER_COUNT; ++i)
+        {
+            fds[i] = fds[0] >= 0 ? openCounter(configs[i], fds[0]) : -1;
+        }
+#else
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+        {
+            fds[i] = -1;
+        }
+#endif
+        owner = std::this_thread::get_id();
+    }
 
-        // checks if the file is open
-        if (inputFile.is_open())
+    void closeAll()
+    {
+#ifdef __linux__
+        for (int i = COUNTER_COUNT - 1; i >= 0; --i)
         {
-            std::string line;
-            while (std::getline(inputFile, line))
+            if (fds[i] >= 0)
             {
-                std::vector<std::string> row;
-                std::stringstream ss(line);
-                std::string cell;
-
-                while (std::getline(ss, cell, ','))
-                {
-                    row.push_back(cell);
-                }
-                csvData.push_back(row);
+                close(fds[i]);
             }
+        }
+#endif
+    }
 
-            // display the CSV data
-            std::cout << "CSV content: " << std::endl;
-            for (const auto &row : csvData)
-            {
-                for (const auto &cell : row)
-                {
-                    std::cout << cell << " | ";
-                }
-                std::cout << std::endl;
-            }
+    // value, time enabled and time running of one counter, zeros when it is not open
+    struct Reading
+    {
+        uint64_t value = 0;
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+    Reading baseline[COUNTER_COUNT];
 
-            // close file
-            inputFile.close();
-        }
-        else
+    Reading readCounter(int index) const
+    {
+        Reading reading;
+#ifdef __linux__
+        uint64_t data[3];
+        if (fds[index] >= 0 && read(fds[index], data, sizeof(data)) == static_cast<ssize_t>(sizeof(data)))
         {
-            std::cerr << "Unable to open file: " << file_name << std::endl;
+            reading.value = data[0];
+            reading.enabled = data[1];
+            reading.running = data[2];
         }
+#else
+        (void)index;
+#endif
+        return reading;
     }
-    std::string getType() const override
+
+    // count since start, estimated for the whole time the group was enabled. Reset does not clear the counts
+    // the kernel adds from the workers that exited, so the values are taken as differences
+    uint64_t counted(int index) const
     {
-        return "CSV FILE INPUT";
+        Reading now = readCounter(index);
+        uint64_t value = now.value - baseline[index].value;
+        uint64_t enabled = now.enabled - baseline[index].enabled;
+        uint64_t running = now.running - baseline[index].running;
+        if (running == 0)
+        {
+            return 0;
+        }
+        return running >= enabled ? value : static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
     }
 
-    bool userInteraction() override
+public:
+    PerfCounters()
     {
-        // add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        open();
     }
 
-    void displayDescription() const override
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters()
     {
-        std::cout << "This step displays a description and the name of the file" << std::endl;
+        closeAll();
     }
-};
-
-class OutputStep : public Step
-{
-private:
-    int stepNumber;
-    std::string fileName;
-    std::string title;
-    std::string description;
-    std::vector<std::string> contentFromPreviousSteps;
 
-public:
-    OutputStep(int stepNumber, const std::string &fileName, const std::string &title, const std::string &description, const std::vector<std::string> &contentFromPreviousStepss) : stepNumber(stepNumber), fileName(fileName), title(title), description(description), contentFromPreviousSteps(contentFromPreviousSteps) {}
+    // the cycle counter is required, the others are reported as zero when the PMU lacks them
+    bool isAvailable() const
+    {
+        return fds[0] >= 0;
+    }
 
-    void execute() override
+    void start()
     {
-        std::cout << "Executing OutputStep: " << std::endl;
-        std::ofstream outputFile(fileName);
-        if (outputFile.is_open())
+        if (owner != std::this_thread::get_id())
         {
-            // scrie informatii despre pas si continutul de la pasii respectivi in fisier
-            outputFile << "Step Number: " << stepNumber << std::endl;
-            outputFile << "Title: " << title << std::endl;
-            outputFile << "Description: " << description << std::endl;
-
-            // Add content from previous steps
-            for (const std::string &content : contentFromPreviousSteps)
-            {
-                outputFile << content << std::endl;
-            }
-
-            outputFile.close();
-            std::cout << "Output file '" << fileName << "' generated successfully" << std::endl;
+            // a flow of the server is defined on one connection and run on another
+            closeAll();
+            open();
         }
-        else
+#ifdef __linux__
+        if (fds[0] >= 0)
         {
-            std::cerr << "Erorr!! Unable to create output file '" << fileName << "'!" << std::endl;
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+        {
+            baseline[i] = readCounter(i);
         }
     }
 
-    std::string getType() const override
+    PerfCounterValues stop()
     {
-        return "OUTPUT";
+#ifdef __linux__
+        if (fds[0] >= 0)
+        {
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+        PerfCounterValues values;
+        values.cycles = counted(0);
+        values.instructions = counted(1);
+        values.cacheMisses = counted(2);
+        values.branchMisses = counted(3);
+        return values;
     }
+};
 
-    void displayDescription() const override
-    {
-        std::cout << "Step number: " << stepNumber << std::endl;
-        std::cout << "File Name: " << fileName << std::endl;
-        std::cout << "Title: " << title << std::endl;
-        std::cout << "Description: " << description << std::endl;
+// one record for the output sinks, formatted once and shared by all of them
+typedef std::shared_ptr<const std::string> OutputRecord;
 
-        // display content from previous steps
-        for (const std::string &content : contentFromPreviousSteps)
+// destination of the records published in an output pipeline; write is only called by the sink thread
+class OutputSink
+{
+public:
+    virtual void write(const std::vector<OutputRecord> &batch) = 0;
+    virtual std::string getName() const = 0;
+    virtual ~OutputSink() = default;
+};
+
+// writes to the standard output of the process from the sink thread, one whole record per fwrite, so a
+// record is never split by the output of the steps but lands between their lines as the thread drains.
+// It is not std::cout: the server and the load generator rebind std::cout to a client or to a discarded
+// buffer, so they refuse this sink (see OutputPipeline::writesToStdout)
+class StdoutSink : public OutputSink
+{
+public:
+    void write(const std::vector<OutputRecord> &batch) override
+    {
+        for (const OutputRecord &record : batch)
         {
-            std::cout << content << std::endl;
+            std::fwrite(record->data(), 1, record->size(), stdout);
         }
+        std::fflush(stdout);
     }
 
-    bool userInteraction() override
+    std::string getName() const override
     {
-        // add logic for user interaction specific to TextStep
-        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
-        char choice;
-        std::cin >> choice;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-        return (choice != 'N' && choice != 'n');
+        return "stdout";
     }
 };
 
-class EndStep : public Step
+class FileSink : public OutputSink
 {
+private:
+    std::string fileName;
+    std::ofstream file;
+
 public:
-    void execute() override
+    FileSink(const std::string &fileName, bool append) : fileName(fileName), file(fileName, append ? std::ios::app : std::ios::trunc)
     {
-        std::cout << "End of the flow\n";
+        if (!file.is_open())
+        {
+            std::cerr << "Error: Unable to open output file '" << fileName << "'." << std::endl;
+        }
     }
 
-    std::string getType() const override
+    void write(const std::vector<OutputRecord> &batch) override
     {
-        return "END";
+        TraceScope ioScope("io", "write ", fileName);
+        for (const OutputRecord &record : batch)
+        {
+            file.write(record->data(), static_cast<std::streamsize>(record->size()));
+        }
+        file.flush();
     }
 
-    void displayDescription() const override
+    std::string getName() const override
     {
-        std::cout << "This step is the end of the flow" << std::endl;
+        return fileName;
     }
 };
 
-class ProcessBuilder
+// file sink that starts a new file once the current one reaches maxBytes: name -> name.1 -> ... -> name.<maxFiles>
+class RotatingFileSink : public OutputSink
 {
 private:
-    std::vector<Step *> steps; // vector to held steps in the flow
-    std::string flowName;
-    time_t creationTimestamp;
-
-    // Analytics
-    int startCount;
-    int completionCount;
-    std::unordered_map<std::string, int> screenSkipCount;  // count of skipped screens for each step type
-    std::unordered_map<std::string, int> errorScreenCount; // count for error screens for each step type
-    int totalErrorCount;
+    std::string fileName;
+    uint64_t maxBytes;
+    int maxFiles;
+    uint64_t currentBytes;
+    std::ofstream file;
 
-public:
-    // constructor to initialize analytics variables
-    ProcessBuilder()
+    void rotate()
     {
-        creationTimestamp = time(nullptr); // set the creation time stamp to the current time
-        startCount = 0;
-        completionCount = 0;
-        totalErrorCount = 0;
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(fileName + "." + std::to_string(maxFiles), error);
+        for (int i = maxFiles - 1; i >= 1; --i)
+        {
+            std::filesystem::rename(fileName + "." + std::to_string(i), fileName + "." + std::to_string(i + 1), error);
+        }
+        std::filesystem::rename(fileName, fileName + ".1", error);
+        file.open(fileName, std::ios::trunc);
+        currentBytes = 0;
     }
 
-    // destructor to clean up allocated steps
-    ~ProcessBuilder()
+public:
+    RotatingFileSink(const std::string &fileName, uint64_t maxBytes, int maxFiles)
+        : fileName(fileName), maxBytes(std::max<uint64_t>(1, maxBytes)), maxFiles(std::max(1, maxFiles)), currentBytes(0), file(fileName, std::ios::app)
     {
-        for (Step *step : steps)
+        std::error_code error;
+        currentBytes = std::filesystem::file_size(fileName, error);
+        if (error)
         {
-            delete step;
+            currentBytes = 0;
         }
     }
 
-    void setFlowName(const std::string &name)
+    void write(const std::vector<OutputRecord> &batch) override
     {
-        flowName = name;
+        TraceScope ioScope("io", "write ", fileName);
+        for (const OutputRecord &record : batch)
+        {
+            if (currentBytes > 0 && currentBytes + record->size() > maxBytes)
+            {
+                rotate();
+            }
+            file.write(record->data(), static_cast<std::streamsize>(record->size()));
+            currentBytes += record->size();
+        }
+        file.flush();
     }
 
-    std::string getFlowName() const
+    std::string getName() const override
     {
-        return flowName;
+        return fileName + " (rotating)";
     }
+};
 
-    // function to add a step to the flow, permite adaugarea oricarui tip de pasi
-    template <typename T, typename... Args>
-    void addStep(Args &&...args)
+// fans the records published by the steps out to several sinks. Every sink has its own lock-free ring
+// buffer and thread which drains it in batches, so producers only format a record once and return
+// without waiting for any I/O (they only spin when a ring is full)
+class OutputPipeline
+{
+private:
+    struct SinkChannel
     {
-        steps.push_back(new T(std::forward<Args>(args)...));
-    }
+        std::unique_ptr<OutputSink> sink;
+        MpscRingBuffer<OutputRecord, 4096> records;
+        std::thread worker;
+    };
 
-    void runFlow()
-    {
-        startCount++;
-        std::cout << "Running flow '" << flowName << "' created at: " << std::asctime(std::localtime(&creationTimestamp));
+    static const size_t MAX_BATCH = 256;
 
-        std::vector<std::string> contentFromPreviousSteps;
-        size_t currentStepIndex = 0;
+    std::vector<std::unique_ptr<SinkChannel>> channels;
+    std::atomic<bool> closed{false};       // set by close, later records are refused
+    std::atomic<size_t> activePublishers{0}; // publish calls in progress, close waits for them
+    std::atomic<bool> stopping{false};     // set once no publish is in progress, the sink threads then finish
+    std::atomic<bool> started{false};
+    std::once_flag startOnce;
 
-        // parcurgem pasii flow-ului si ii executa, afisand pasul curent
-        while (currentStepIndex < steps.size())
+    void drain(SinkChannel &channel)
+    {
+        std::vector<OutputRecord> batch;
+        batch.reserve(MAX_BATCH);
+        while (true)
         {
-            Step *currentStep = steps[currentStepIndex];
-            std::cout << "Executing step: " << currentStep->getType() << std::endl;
-
-            // prompt user to decide if he wants to execute a step or to skip it
-            std::cout << "Do you want to execute this step? (y/n): ";
-            char userChoice;
-            std::cin >> userChoice;
-            if (userChoice == 'Y' || userChoice == 'y')
+            bool stopRequested = stopping.load(std::memory_order_acquire); // read before popping so nothing published earlier is lost
+            OutputRecord record;
+            while (batch.size() < MAX_BATCH && channel.records.pop(record))
             {
-                currentStep->execute();
-
-                // daca pasul este output, extragem continutul de aici
-                if (currentStep->getType() == "OUTPUT")
-                {
-                    const OutputStep *outputStep = dynamic_cast<const OutputStep *>(currentStep);
-                    if (outputStep)
-                    {
-                        // extract content from the OUTPUT step and store it
-                        outputStep->displayDescription(); // display OUTPUT step details
-                        contentFromPreviousSteps.push_back("Content from output step");
-                    }
-                }
-
-                if (currentStep->getType() == "CALCULUS")
-                {
-                    const CalculusStep *calculusStep = dynamic_cast<const CalculusStep *>(currentStep);
-                    if (calculusStep)
-                    {
-                        // Update error screen count for CALCULUS step
-                        errorScreenCount[currentStep->getType()] += calculusStep->getResult();
-                    }
-                }
-
-                currentStepIndex++;
+                batch.push_back(std::move(record));
             }
-            else
+            if (!batch.empty())
             {
-                std::cout << "Skipping to the next step..." << std::endl;
-                screenSkipCount[currentStep->getType()]++;
+                channel.sink->write(batch);
+                batch.clear();
                 continue;
             }
-
-            if (currentStep->getType() == "CALCULUS")
+            if (stopRequested)
             {
-                const CalculusStep *calculusStep = dynamic_cast<const CalculusStep *>(currentStep);
-                if (calculusStep)
-                {
-                    // Update error screen count for CALCULUS step
-                    errorScreenCount[currentStep->getType()] += calculusStep->getResult();
-                }
+                return;
             }
-
-            // wait for user confirmation to proceed to the next step
-            std::cout << "Press enter to proceed to the next step...";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
         }
+    }
 
-        // daca ultimul pas e de tip calculus, afiseaza rezultatul final
-        const CalculusStep *lastCalculusStep = dynamic_cast<const CalculusStep *>(steps.back());
-        if (lastCalculusStep)
+public:
+    OutputPipeline() = default;
+    OutputPipeline(const OutputPipeline &) = delete;
+    OutputPipeline &operator=(const OutputPipeline &) = delete;
+
+    ~OutputPipeline()
+    {
+        close();
+    }
+
+    // sinks can only be added before the first record is published
+    void addSink(std::unique_ptr<OutputSink> sink)
+    {
+        if (started)
         {
-            std::cout << "Final Result: " << lastCalculusStep->getResult() << std::endl;
+            throw std::logic_error("Sinks must be added before the pipeline starts.");
         }
+        channels.push_back(std::make_unique<SinkChannel>());
+        channels.back()->sink = std::move(sink);
+    }
 
-        completionCount++;
-        std::cout << "Flow completed." << std::endl;
+    bool hasSinks() const
+    {
+        return !channels.empty();
     }
 
-    // function to report an error for a specific step type
-    void reportError(const std::string &stepType)
+    // true when a sink writes to the standard output of the process
+    bool writesToStdout() const
     {
-        errorScreenCount[stepType]++;
-        totalErrorCount++;
+        for (const auto &channel : channels)
+        {
+            if (channel->sink->getName() == "stdout")
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
-    // function to display analytics for the flow
-    void displayAnalytics() const
+    void start()
     {
-        std::cout << "Analytics for flow '" << flowName << "':" << std::endl;
-        std::cout << "Flow started: " << startCount << " times" << std::endl;
-        std::cout << "Flow completed: " << completionCount << " times" << std::endl;
+        std::call_once(startOnce, [this]()
+                       {
+            for (auto &channel : channels)
+            {
+                SinkChannel *current = channel.get();
+                current->worker = std::thread([this, current]()
+                                              { drain(*current); });
+            }
+            started.store(true, std::memory_order_release); });
+    }
 
-        std::cout << "Screen skip counts:" << std::endl;
-        for (const auto &entry : screenSkipCount)
+    // queues the record for every sink; false when the pipeline is closed. A step past its deadline stops
+    // waiting for a full ring only before the first sink took the record, so it reaches every sink or none
+    bool publish(std::string text)
+    {
+        // seq_cst with close: either close sees this publish in progress or this publish sees closed
+        activePublishers.fetch_add(1);
+        if (closed.load())
         {
-            std::cout << entry.first << ": " << entry.second << " times" << std::endl;
+            activePublishers.fetch_sub(1);
+            return false;
         }
+        struct PublishScope
+        {
+            std::atomic<size_t> &count;
+            ~PublishScope()
+            {
+                count.fetch_sub(1, std::memory_order_release);
+            }
+        } scope{activePublishers};
 
-        std::cout << "Error screen counts:" << std::endl;
-        for (const auto &entry : errorScreenCount)
+        start();
+        OutputRecord record = std::make_shared<const std::string>(std::move(text));
+        bool queued = false;
+        for (auto &channel : channels)
         {
-            std::cout << entry.first << ": " << entry.second << " times" << std::endl;
+            while (!channel->records.push(record))
+            {
+                // ring full, wait for the sink to catch up
+                if (!queued)
+                {
+                    CancellationToken::checkpoint();
+                }
+                std::this_thread::yield();
+            }
+            queued = true;
         }
+        return true;
+    }
 
-        if (completionCount > 0)
+    // refuses new records, writes everything still queued and stops the sink threads
+    void close()
+    {
+        closed.store(true);
+        while (activePublishers.load(std::memory_order_acquire) > 0)
         {
-            double averageErrors = static_cast<double>(totalErrorCount) / completionCount;
-            std::cout << "Average number of errors per flow completed: " << averageErrors << std::endl;
+            std::this_thread::yield();
         }
-        else
+        stopping.store(true, std::memory_order_release);
+        for (auto &channel : channels)
         {
-            std::cout << "Average number of errors per flow completed: N/A (no completions)" << std::endl;
+            if (channel->worker.joinable())
+            {
+                channel->worker.join();
+            }
         }
     }
 
-    // function to delete a flow
-    void deleteFlow(const std::string &flowToDelete)
+    // sinks from a description like "stdout,file:archive.txt,rotate:log.txt:1048576:5"
+    static bool addSinks(OutputPipeline &pipeline, const std::string &description)
     {
-        // check if the flow we eant to delete matches the current flow
-        if (flowToDelete == flowName)
+        std::stringstream sinks(description);
+        std::string sink;
+        while (std::getline(sinks, sink, ','))
         {
-            throw "Deleting flow";
-            std::cout << flowToDelete << "'..." << std::endl;
-            // clean up allocated steps
-            for (Step *step : steps)
+            std::vector<std::string> parts;
+            std::stringstream fields(sink);
+            std::string field;
+            while (std::getline(fields, field, ':'))
             {
-                delete step;
+                parts.push_back(field);
+            }
+            if (parts.size() == 1 && parts[0] == "stdout")
+            {
+                pipeline.addSink(std::make_unique<StdoutSink>());
+            }
+            else if (parts.size() == 2 && parts[0] == "file")
+            {
+                pipeline.addSink(std::make_unique<FileSink>(parts[1], true));
+            }
+            else if (parts.size() == 4 && parts[0] == "rotate")
+            {
+                pipeline.addSink(std::make_unique<RotatingFileSink>(parts[1], std::strtoull(parts[2].c_str(), nullptr, 10), std::atoi(parts[3].c_str())));
+            }
+            else
+            {
+                std::cerr << "Error: Invalid output sink '" << sink << "'." << std::endl;
+                return false;
             }
-            // clear the step vector
-            steps.clear();
-            // reset analytics
-            startCount = 0;
-            completionCount = 0;
-            screenSkipCount.clear();
-            errorScreenCount.clear();
-            totalErrorCount = 0;
-            // reset flow name
-            flowName.clear();
-        }
-        else
-        {
-            std::cerr << "Error!!! Flow '" << flowToDelete << "' not found" << std::endl;
         }
+        return true;
     }
+};
 
-    void displayAvailableSteps() const
+// Numeric conversions shared by the input steps, the CSV columns and the outputs. They use
+// std::from_chars / std::to_chars: no locale, no stream state, no allocation, and formatting
+// produces the shortest text that parses back to exactly the same value.
+
+// parses the whole text (surrounding spaces and a leading '+' allowed) as a number,
+// returns false for empty or non-numeric text
+template <typename T>
+inline bool parseNumber(std::string_view text, T &number)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
     {
-        std::cout << "Available steps: " << std::endl;
-        for (const Step *step : steps)
-        {
-            std::cout << "- Type: " << step->getType() << std::endl;
-            step->displayDescription();
-            std::cout << std::endl;
-        }
+        text.remove_prefix(1);
     }
-
-    std::string getCreationTimestamp() const
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
     {
-        return std::asctime(std::localtime(&creationTimestamp)); // Convert timestamp to a readable string
+        text.remove_suffix(1);
     }
-};
+    if (!text.empty() && text.front() == '+')
+    {
+        text.remove_prefix(1);
+    }
+    if (text.empty())
+    {
+        return false;
+    }
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), number);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
 
-int main()
+// parseNumber for the cells and the values they are compared with: from_chars also reads "nan" and "inf",
+// which would match every comparison (NaN) or poison a sum, so such a cell is text, not a number
+inline bool parseFiniteNumber(std::string_view text, double &number)
 {
-    ProcessBuilder process;
+    return parseNumber(text, number) && std::isfinite(number);
+}
 
-    std::string flowName;
-    std::cout << "Enter the name for your flow: ";
-    std::getline(std::cin, flowName);
-    process.setFlowName(flowName);
+// appends the shortest exact text of the number
+template <typename T>
+inline void appendNumber(std::string &text, T number)
+{
+    char buffer[64];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    text.append(buffer, result.ptr);
+}
 
-    process.displayAvailableSteps();
-    std::cout << "Choose one of the following steps: " << endl;
-    std::cout << "1. Title Step" << endl;
-    std::cout << "2. Text Step" << endl;
-    std::cout << "3. Text Input Step" << endl;
-    std::cout << "4. CSV Input Step" << endl;
-    std::cout << "5. Number Input Step" << endl;
-    std::cout << "6. Calculus Step" << endl;
-    std::cout << "7. Display Step" << endl;
-    std::cout << "8. Text File Input Step" << endl;
-    std::cout << "9. CSV File Input Step" << endl;
-    std::cout << "10. Output Step" << endl;
-    std::cout << "11. End Step" << endl;
+template <typename T>
+inline std::string formatNumber(T number)
+{
+    std::string text;
+    appendNumber(text, number);
+    return text;
+}
+
+// streaming 64-bit hash used to fingerprint steps and records: 8 bytes per round, each mixed with the
+// murmur3 finalizer. Not cryptographic, but 64 bits keep accidental collisions negligible for millions of records
+class Fingerprint
+{
+private:
+    uint64_t state;
 
-    // dynamically add steps to the flow based on user input
-    char addMore;
-    do
+    static uint64_t mix(uint64_t value)
     {
-        std::cout << "Enter the type of step to add (TITLE, TEXT, NUMBER, etc.): ";
-        std::string stepType;
-        std::getline(std::cin, stepType);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return value;
+    }
 
-        if (stepType == "TITLE")
+    void addWord(uint64_t word)
+    {
+        state = (state ^ mix(word)) * 0x9fb21c651e98df25ULL;
+    }
+
+public:
+    Fingerprint() : state(0x9e3779b97f4a7c15ULL) {}
+
+    // the length is hashed as well, so the field sequences ("ab", "c") and ("a", "bc") differ
+    Fingerprint &add(std::string_view text)
+    {
+        const char *data = text.data();
+        size_t size = text.size();
+        for (; size >= 8; data += 8, size -= 8)
         {
-            std::string title, subtitle;
-            std::cout << "Enter title: ";
-            std::cin >> title;
-            std::cout << "Enter subtitle: ";
-            std::cin >> subtitle;
-            process.addStep<TitleStep>(title, subtitle);
+            uint64_t word;
+            memcpy(&word, data, 8);
+            addWord(word);
         }
+        uint64_t tail = 0;
+        memcpy(&tail, data, size);
+        addWord(tail);
+        addWord(text.size());
+        return *this;
+    }
 
-        else if (stepType == "TEXT")
-        {
-            std::string title;
+    Fingerprint &add(uint64_t value)
+    {
+        addWord(value);
+        return *this;
+    }
+
+    uint64_t digest() const
+    {
+        return mix(state);
+    }
+
+    // second, independent hash of a fingerprint, used for double hashing
+    static uint64_t rehash(uint64_t fingerprint)
+    {
+        return mix(fingerprint ^ 0xc2b2ae3d27d4eb4fULL);
+    }
+};
+
+enum class DuplicateMode
+{
+    Exact, // set of all the fingerprints seen
+    Bloom  // fixed size Bloom filter: bounded memory, a few false duplicates
+};
+
+// finds repeated records in one pass from their fingerprints
+class DuplicateDetector
+{
+private:
+    DuplicateMode mode;
+    std::vector<uint64_t> slots; // exact: open addressing set, 0 marks a free slot
+    size_t usedSlots;
+    std::vector<uint64_t> bits; // bloom: bit array
+    uint64_t bitCount;
+    int hashCount;
+    size_t recordCount;
+    size_t duplicateCount;
+
+    bool insertExact(uint64_t fingerprint)
+    {
+        fingerprint = fingerprint == 0 ? 1 : fingerprint;
+        if ((usedSlots + 1) * 2 > slots.size()) // keep the load factor under 0.5
+        {
+            std::vector<uint64_t> oldSlots(slots.size() * 2, 0);
+            oldSlots.swap(slots);
+            for (uint64_t old : oldSlots)
+            {
+                if (old != 0)
+                {
+                    size_t index = old & (slots.size() - 1);
+                    while (slots[index] != 0)
+                    {
+                        index = (index + 1) & (slots.size() - 1);
+                    }
+                    slots[index] = old;
+                }
+            }
+        }
+        size_t index = fingerprint & (slots.size() - 1);
+        while (slots[index] != 0)
+        {
+            if (slots[index] == fingerprint)
+            {
+                return false;
+            }
+            index = (index + 1) & (slots.size() - 1);
+        }
+        slots[index] = fingerprint;
+        usedSlots++;
+        return true;
+    }
+
+    bool insertBloom(uint64_t fingerprint)
+    {
+        uint64_t step = Fingerprint::rehash(fingerprint) | 1;
+        bool inserted = false;
+        for (int i = 0; i < hashCount; ++i)
+        {
+            uint64_t bit = (fingerprint + i * step) % bitCount;
+            uint64_t mask = 1ULL << (bit & 63);
+            if (!(bits[bit >> 6] & mask))
+            {
+                bits[bit >> 6] |= mask;
+                inserted = true;
+            }
+        }
+        return inserted;
+    }
+
+public:
+    // expectedRecords and falsePositiveRate size the Bloom filter, the exact set grows as needed
+    explicit DuplicateDetector(DuplicateMode mode, size_t expectedRecords = 1 << 20, double falsePositiveRate = 0.001)
+        : mode(mode), usedSlots(0), bitCount(64), hashCount(1), recordCount(0), duplicateCount(0)
+    {
+        if (mode == DuplicateMode::Exact)
+        {
+            slots.assign(1024, 0);
+            return;
+        }
+        double records = static_cast<double>(std::max<size_t>(expectedRecords, 1));
+        double optimalBits = -records * std::log(falsePositiveRate) / (std::log(2.0) * std::log(2.0));
+        bitCount = std::max<uint64_t>(64, (static_cast<uint64_t>(optimalBits) + 63) / 64 * 64);
+        hashCount = std::max(1, static_cast<int>(std::lround(bitCount / records * std::log(2.0))));
+        bits.assign(bitCount / 64, 0);
+    }
+
+    // returns true when the record was seen before (in Bloom mode: probably seen before)
+    bool add(uint64_t fingerprint)
+    {
+        recordCount++;
+        bool inserted = mode == DuplicateMode::Exact ? insertExact(fingerprint) : insertBloom(fingerprint);
+        if (!inserted)
+        {
+            duplicateCount++;
+        }
+        return !inserted;
+    }
+
+    DuplicateMode getMode() const
+    {
+        return mode;
+    }
+
+    size_t getRecordCount() const
+    {
+        return recordCount;
+    }
+
+    size_t getDuplicateCount() const
+    {
+        return duplicateCount;
+    }
+};
+
+class Step
+{
+public:
+    // declaratie functie virtuala pura care sa fie executata in clasele derivate
+    virtual void execute() = 0;
+    virtual std::string getType() const = 0;
+    // functie virtuala cu implementare implicita. Returneaza true dar poate fi suprascrisa in clasele derivate
+    virtual bool userInteraction()
+    {
+        return true;
+    }
+    // functie virtuala cu implementare implicita
+    virtual void displayDescription() const
+    {
+        std::cout << "No description available for this step" << std::endl;
+    }
+    // steps that write output hand it to the pipeline instead of writing it themselves; ignored by the others
+    virtual void setOutputPipeline(OutputPipeline *pipeline)
+    {
+        (void)pipeline;
+    }
+    // adds the parameters of the step to its fingerprint
+    virtual void addFingerprint(Fingerprint &fingerprint) const
+    {
+        (void)fingerprint;
+    }
+    // passes the fingerprint of every record captured by the step (rows, text inputs) to visit
+    virtual void fingerprintRecords(const std::function<void(uint64_t)> &visit) const
+    {
+        (void)visit;
+    }
+    // step whose result this step reads, nullptr for the steps that read no other step
+    virtual const Step *getSource() const
+    {
+        return nullptr;
+    }
+    // type plus parameters: two steps with the same fingerprint are configured the same way
+    uint64_t fingerprint() const
+    {
+        Fingerprint fingerprint;
+        fingerprint.add(getType());
+        addFingerprint(fingerprint);
+        return fingerprint.digest();
+    }
+    virtual ~Step() = default;
+};
+
+class TitleStep : public Step
+{
+private:
+    std::string title;
+    std::string subtitle;
+
+public:
+    // constructor for title step
+    TitleStep(const std::string &title, const std::string &subtitle) : title(title), subtitle(subtitle) {}
+
+    void execute() override
+    {
+        std::cout << "Title: " << title << "\nSubtitle: " << subtitle << "\n";
+    }
+
+    std::string getType() const override
+    {
+        return "TITLE";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(title).add(subtitle);
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to title step
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a title and a subtitle" << std::endl;
+    }
+};
+
+class TextStep : public Step
+{
+private:
+    std::string title;
+    std::string copy;
+
+public:
+    // constructor for text step
+    TextStep(const std::string &title, const std::string &copy) : title(title), copy(copy) {}
+
+    void execute() override
+    {
+        std::cout << "Title: " << title << "\nCopy: " << copy << "\n";
+    }
+
+    std::string getType() const override
+    {
+        return "TEXT";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(title).add(copy);
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a title and a copy" << std::endl;
+    }
+};
+
+class TextInputStep : public Step
+{
+private:
+    std::string textInput;
+    std::string description;
+
+public:
+    // constructor fot text input step
+    TextInputStep(const std::string &description) : description(description) {}
+
+    void execute() override
+    {
+        std::cout << "Description: " << description << std::endl;
+        std::cout << "Enter text: ";
+        TraceScope waitScope("wait", "text input");
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        std::getline(std::cin, textInput);
+    }
+
+    std::string getType() const override
+    {
+        return "TEXT INPUT";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(description);
+    }
+
+    void fingerprintRecords(const std::function<void(uint64_t)> &visit) const override
+    {
+        if (!textInput.empty())
+        {
+            visit(Fingerprint().add(textInput).digest());
+        }
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a text and a description" << std::endl;
+    }
+
+    std::string getTextInput() const
+    {
+        return textInput;
+    }
+};
+
+class CSVInputStep : public Step
+{
+private:
+    std::string description;
+    std::string CSVInput;
+    std::string fileName;
+    OutputPipeline *outputPipeline; // when set, the data goes to the pipeline sinks instead of fileName
+    bool savedToFile;               // fileName holds CSVInput since the last execution
+
+public:
+    // constructor for csv input step
+    CSVInputStep(const std::string &description) : description(description), outputPipeline(nullptr), savedToFile(false) {}
+
+    void execute() override
+    {
+        std::cout << "Description: " << description << std::endl;
+        std::cout << "Enter CSV data: ";
+        TraceScope waitScope("wait", "CSV input");
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer (previne consumul neasteptat al unor caractere ramase in buffer dupa citirea valorilor)
+        std::getline(std::cin, CSVInput);
+
+        std::cout << "Enter the filename to save the CSV data: ";
+        std::getline(std::cin, fileName);
+
+        // save CSV data to the file
+        savedToFile = saveCsvToFile();
+    }
+
+    std::string getType() const override
+    {
+        return "CSV INPUT";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(description);
+    }
+
+    void fingerprintRecords(const std::function<void(uint64_t)> &visit) const override
+    {
+        if (!CSVInput.empty())
+        {
+            visit(Fingerprint().add(CSVInput).digest());
+        }
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "Expected input: " << description << std::endl;
+    }
+
+    void setOutputPipeline(OutputPipeline *pipeline) override
+    {
+        outputPipeline = pipeline;
+    }
+
+    // returneaza datele csv introduse de utilizator
+    const std::string &getCSVInput() const
+    {
+        return CSVInput;
+    }
+
+    // returneaza numele fisierului dat de utilizator
+    std::string getFileName() const
+    {
+        return fileName;
+    }
+
+    bool isSavedToFile() const
+    {
+        return savedToFile;
+    }
+
+    // function to save csv data to the specified files, returns true when the data is in the file
+    bool saveCsvToFile() const
+    {
+        if (outputPipeline)
+        {
+            if (outputPipeline->publish(CSVInput + "\n"))
+            {
+                std::cout << "CSV data published to the output sinks" << std::endl;
+            }
+            else
+            {
+                std::cerr << "Error: The output sinks are closed, the CSV data was not published." << std::endl;
+            }
+            return false;
+        }
+        TraceScope ioScope("io", "write ", fileName);
+        std::ofstream outputFile(fileName);
+        if (outputFile.is_open())
+        {
+            outputFile << CSVInput;
+            outputFile.close();
+            std::cout << "CSV data saved to file: " << fileName << std::endl;
+            return static_cast<bool>(outputFile);
+        }
+        std::cerr << "Error: Unable to save CSV data to file '" << fileName << "'." << std::endl;
+        return false;
+    }
+};
+
+class NumberInputStep : public Step
+{
+private:
+    std::string description;
+    float numberInput;
+
+public:
+    // constructor for number input step; number is the value until the step reads one (e.g. an operand of an expression)
+    NumberInputStep(const std::string &description, float number = 0.0f) : description(description), numberInput(number) {}
+
+    void execute() override
+    {
+        std::cout << "Description: " << description << std::endl;
+        std::cout << "Enter a number: ";
+        std::string token;
+        {
+            TraceScope waitScope("wait", "number input");
+            std::cin >> token;
+        }
+
+        // if the reading doesn't work
+        if (std::cin.fail() || !parseNumber(token, numberInput))
+        {
+            std::cin.clear(); // resetarea starii obiectului std::cin
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            throw std::invalid_argument("Invalid input. Please enter a valid number.");
+        }
+
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    std::string getType() const override
+    {
+        return "NUMBER INPUT";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(description);
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a description and a number" << std::endl;
+    }
+
+    float getNumberInput() const
+    {
+        return numberInput;
+    }
+};
+
+class CalculusStep : public Step
+{
+private:
+    // set a vector to the previous steps to be able to effectuate the operations on them
+    std::vector<NumberInputStep *> previousSteps; // vector de pasi anteriori
+    std::vector<char> operations;                 // vector de operatii matematice
+    float result;
+    OperationType operationType; // alegem tipul de operatie matematica
+    bool ownsOperands;           // false when the operands are steps owned by the flow itself
+
+public:
+    // constructor fot calculus step
+    CalculusStep(const std::vector<NumberInputStep *> &steps, const std::vector<char> &ops, OperationType opType) : previousSteps(steps), operations(ops), result(0.0f), operationType(opType), ownsOperands(true) {}
+
+    // afiseaza expresia si implementeaza operatia matematica
+    void execute() override
+    {
+        std::cout << "Expression: ";
+        for (size_t i = 0; i < previousSteps.size(); ++i)
+        {
+            std::cout << "Step: " << i + 1;
+            if (i < operations.size())
+            {
+                std::cout << " " << operations[i] << " ";
+            }
+        }
+        std::cout << std::endl;
+
+        // perform the operation
+        result = previousSteps[0]->getNumberInput();
+
+        for (size_t i = 0; i < operations.size(); ++i)
+        {
+            float operand = previousSteps[i + 1]->getNumberInput();
+
+            switch (operationType)
+            {
+            case OperationType::Addition:
+                result += operand;
+                break;
+            case OperationType::Substraction:
+                result -= operand;
+                break;
+            case OperationType::Multiplication:
+                result *= operand;
+                break;
+            case OperationType::Division:
+                if (operand != 0)
+                {
+                    result /= operand;
+                }
+                else
+                {
+                    std::cerr << "Error!! Division by 0!" << std::endl;
+                }
+                break;
+            case OperationType::Minimum:
+                result = std::min(result, operand);
+                break;
+            case OperationType::Maximum:
+                result = std::max(result, operand);
+                break;
+            default:
+                std::cerr << "Invalid operation: " << operations[i] << std::endl;
+                break;
+            }
+        }
+        std::cout << "Result: " << formatNumber(result) << std::endl;
+    }
+
+    std::string getType() const override
+    {
+        return "CALCULUS";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(static_cast<uint64_t>(operationType));
+        for (const NumberInputStep *step : previousSteps)
+        {
+            fingerprint.add(step->fingerprint());
+        }
+        fingerprint.add(std::string_view(operations.data(), operations.size()));
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays the number of steps, the operation and the operands" << std::endl;
+    }
+
+    float getResult() const
+    {
+        return result;
+    }
+
+    size_t getOperandCount() const
+    {
+        return previousSteps.size();
+    }
+
+    // uses number input steps owned by someone else (e.g. a StaticFlow) as operands
+    void bindOperands(const std::vector<NumberInputStep *> &steps)
+    {
+        if (ownsOperands)
+        {
+            for (NumberInputStep *step : previousSteps)
+            {
+                delete step;
+            }
+        }
+        previousSteps = steps;
+        ownsOperands = false;
+    }
+
+    // destructor care elibereaza memoria ocupata de pasii anteriori
+    ~CalculusStep()
+    {
+        if (!ownsOperands)
+        {
+            return;
+        }
+        for (NumberInputStep *step : previousSteps)
+        {
+            delete step;
+        }
+    }
+};
+
+// buffer of the file streams of the reading steps, set with pubsetbuf so opening a file does not allocate one
+static thread_local std::array<char, 65536> readBuffer;
+
+class TextFileInputStep : public Step
+{
+private:
+    std::string description;
+    std::string fileName;
+    std::string fileContent; // continutul citit din fisier
+    std::string line;        // reused between runs together with fileContent
+    bool contentLoaded = false; // fileContent holds the whole file read by the last run
+
+public:
+    // constructor for text file input step
+    TextFileInputStep(const std::string &description, const std::string &file_name) : description(description), fileName(file_name) {}
+
+    void execute() override
+    {
+        std::cout << "Description: " << description << "\nFile name: " << fileName << std::endl;
+        TraceScope ioScope("io", "read ", fileName);
+        std::ifstream inputFile;
+        inputFile.rdbuf()->pubsetbuf(readBuffer.data(), readBuffer.size());
+        inputFile.open(fileName);
+
+        // check if the file is open
+        if (inputFile.is_open())
+        {
+            // read the content from the file linie cu linie si adauga la continutul total al fisierului
+            fileContent.clear();
+            contentLoaded = false;
+            bool streaming = false; // over the memory budget: the lines are displayed as read, not kept
+            while (!CancellationToken::stopRequested() && std::getline(inputFile, line))
+            {
+                if (streaming)
+                {
+                    std::cout << line << '\n';
+                    continue;
+                }
+                fileContent += line;
+                fileContent += '\n';
+                if (MemoryAccount *account = MemoryAccount::exceededBudget())
+                {
+                    if (account->getPolicy() == MemoryBudgetPolicy::FailFast)
+                    {
+                        std::string().swap(fileContent);
+                        throw MemoryBudgetExceeded(account->budgetMessage());
+                    }
+                    std::cout << "The " << account->budgetMessage() << ", the rest of the file is streamed instead of kept" << std::endl;
+                    std::cout << "File content: \n"
+                              << fileContent;
+                    std::string().swap(fileContent);
+                    streaming = true;
+                }
+            }
+            if (CancellationToken::stopped())
+            {
+                fileContent.clear(); // a part of the file is not kept as if it were the whole file
+                CancellationToken::check();
+            }
+            if (!streaming)
+            {
+                std::cout << "File content: \n"
+                          << fileContent;
+                contentLoaded = true;
+            }
+            std::cout << std::endl;
+            // close the file
+            inputFile.close();
+        }
+        else
+        {
+            std::cerr << "Unable to open the file: " << fileName << std::endl;
+        }
+    }
+
+    std::string getType() const override
+    {
+        return "TEXT FILE INPUT";
+    }
+
+    const std::string &getFileName() const
+    {
+        return fileName;
+    }
+
+    // content read by the last run, empty when the file was streamed past the memory budget
+    const std::string &getFileContent() const
+    {
+        return fileContent;
+    }
+
+    bool isContentLoaded() const
+    {
+        return contentLoaded;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(description).add(fileName);
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        // Add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a description and the name of the file" << std::endl;
+    }
+};
+
+// free list of objects kept with their capacity; acquire returns a released object (or a new one when
+// the list is empty) so repeated runs refill the same strings and vectors instead of allocating new ones
+template <typename T>
+class ObjectPool
+{
+private:
+    std::vector<T> freeObjects;
+
+public:
+    T acquire()
+    {
+        if (freeObjects.empty())
+        {
+            return T();
+        }
+        T object = std::move(freeObjects.back());
+        freeObjects.pop_back();
+        return object;
+    }
+
+    void release(T &&object)
+    {
+        freeObjects.push_back(std::move(object));
+    }
+
+    // frees the released objects
+    void clear()
+    {
+        std::vector<T>().swap(freeObjects);
+    }
+
+    size_t size() const
+    {
+        return freeObjects.size();
+    }
+};
+
+// interned strings: every distinct string is stored once and identified by a small integer id
+class StringPool
+{
+private:
+    std::deque<std::string> strings; // a deque never moves its elements, the map keys view into them
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+public:
+    StringPool() = default;
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    uint32_t intern(std::string_view text)
+    {
+        auto found = ids.find(text);
+        if (found != ids.end())
+        {
+            return found->second;
+        }
+        uint32_t id = static_cast<uint32_t>(strings.size());
+        strings.emplace_back(text);
+        ids.emplace(strings.back(), id);
+        return id;
+    }
+
+    // looks a string up without adding it
+    bool find(std::string_view text, uint32_t &id) const
+    {
+        auto found = ids.find(text);
+        if (found == ids.end())
+        {
+            return false;
+        }
+        id = found->second;
+        return true;
+    }
+
+    const std::string &get(uint32_t id) const
+    {
+        return strings[id];
+    }
+
+    size_t size() const
+    {
+        return strings.size();
+    }
+
+    void clear()
+    {
+        ids.clear();
+        strings.clear();
+    }
+};
+
+// table whose cells are codes stored in one flat array: the cells of row r are codes[rowStarts[r]] ..
+// codes[rowStarts[r + 1] - 1]. A code is the id of the string in the pool of the table, or, for the columns
+// with too many distinct values to gain from interning, the index of the cell kept as plain text. The pool
+// belongs to the table and is emptied with it, so it does not outlive the data read
+class DictionaryTable
+{
+private:
+    // a column stops being interned once more than half of its first SAMPLE_CELLS cells were new strings
+    static constexpr size_t SAMPLE_CELLS = 4096;
+    static constexpr uint32_t PLAIN_CELL = 0x80000000u; // flag of the code of a plain cell, the other bits index it
+
+    struct ColumnStats
+    {
+        size_t cells = 0;
+        size_t newStrings = 0;
+        bool plain = false; // the next cells of the column are kept as plain text
+    };
+
+    StringPool pool;
+    std::vector<uint32_t> codes;
+    std::vector<size_t> rowStarts;
+    std::string plainText;         // the plain cells one after the other
+    std::vector<size_t> plainEnds; // end of every plain cell in plainText
+    std::vector<ColumnStats> columnStats;
+    uint32_t emptyId; // id of "", returned for missing cells
+
+    void reset()
+    {
+        columnStats.clear();
+        pool.clear();
+        emptyId = pool.intern("");
+    }
+
+public:
+    DictionaryTable() : rowStarts(1, 0)
+    {
+        emptyId = pool.intern("");
+    }
+
+    void appendRow(const std::vector<std::string> &row)
+    {
+        for (size_t column = 0; column < row.size(); ++column)
+        {
+            if (column == columnStats.size())
+            {
+                columnStats.emplace_back();
+            }
+            ColumnStats &stats = columnStats[column];
+            if (stats.plain)
+            {
+                plainText += row[column];
+                plainEnds.push_back(plainText.size());
+                codes.push_back(PLAIN_CELL | static_cast<uint32_t>(plainEnds.size() - 1));
+                continue;
+            }
+            size_t knownStrings = pool.size();
+            codes.push_back(pool.intern(row[column]));
+            stats.newStrings += pool.size() - knownStrings;
+            if (++stats.cells == SAMPLE_CELLS && stats.newStrings * 2 > stats.cells)
+            {
+                stats.plain = true;
+            }
+        }
+        rowStarts.push_back(codes.size());
+    }
+
+    void clear()
+    {
+        codes.clear();
+        rowStarts.assign(1, 0);
+        plainText.clear();
+        plainEnds.clear();
+        reset();
+    }
+
+    // clear that also frees the capacity
+    void release()
+    {
+        std::vector<uint32_t>().swap(codes);
+        std::vector<size_t>(1, 0).swap(rowStarts);
+        std::string().swap(plainText);
+        std::vector<size_t>().swap(plainEnds);
+        reset();
+    }
+
+    // true when every cell of the column is a pool id, so equal cells have equal ids
+    bool isColumnEncoded(size_t column) const
+    {
+        return column >= columnStats.size() || !columnStats[column].plain;
+    }
+
+    size_t getPlainColumnCount() const
+    {
+        return static_cast<size_t>(std::count_if(columnStats.begin(), columnStats.end(), [](const ColumnStats &stats)
+                                                 { return stats.plain; }));
+    }
+
+    size_t getRowCount() const
+    {
+        return rowStarts.size() - 1;
+    }
+
+    size_t getCellCount(size_t row) const
+    {
+        return rowStarts[row + 1] - rowStarts[row];
+    }
+
+    uint32_t getCellId(size_t row, size_t column) const
+    {
+        return column < getCellCount(row) ? codes[rowStarts[row] + column] : emptyId;
+    }
+
+    // the text of a code of the table
+    std::string_view getString(uint32_t code) const
+    {
+        if (code & PLAIN_CELL)
+        {
+            size_t index = code & ~PLAIN_CELL;
+            size_t start = index > 0 ? plainEnds[index - 1] : 0;
+            return std::string_view(plainText).substr(start, plainEnds[index] - start);
+        }
+        return pool.get(code);
+    }
+
+    std::string_view getCell(size_t row, size_t column) const
+    {
+        return getString(getCellId(row, column));
+    }
+
+    const StringPool &getPool() const
+    {
+        return pool;
+    }
+
+    // bytes used by the codes, row offsets and plain cells, without the strings of the pool
+    size_t getMemoryUsage() const
+    {
+        return codes.capacity() * sizeof(uint32_t) + rowStarts.capacity() * sizeof(size_t) + plainText.capacity() + plainEnds.capacity() * sizeof(size_t);
+    }
+};
+
+// CSV rows kept as the raw text of the file, nothing is split when the file is read. The columns declared
+// with addColumn are split on their first access and kept as views into the text; the other cells are
+// found by scanning their line every time they are read
+class RawCSVTable
+{
+private:
+    struct Column
+    {
+        size_t column;
+        std::mutex mutex;
+        std::atomic<bool> ready{false};
+        std::vector<std::string_view> cells; // data() == nullptr when the row has no such cell
+
+        explicit Column(size_t column) : column(column) {}
+    };
+
+    static constexpr size_t READ_CHUNK_SIZE = 16 * 1024 * 1024;
+
+    std::string text;
+    std::vector<size_t> lineStarts; // start of every line, then the end of the last line + 1
+    std::vector<std::unique_ptr<Column>> columns;
+
+    // same cells as splitting the line at the commas: a trailing comma does not start an empty cell
+    static bool findCell(std::string_view line, size_t column, std::string_view &cell)
+    {
+        size_t start = 0;
+        for (size_t i = 0; start < line.size(); ++i)
+        {
+            size_t end = line.find(',', start);
+            if (end == std::string_view::npos)
+            {
+                end = line.size();
+            }
+            if (i == column)
+            {
+                cell = line.substr(start, end - start);
+                return true;
+            }
+            start = end + 1;
+        }
+        return false;
+    }
+
+    // the column, split on the first call; nullptr when it was not declared
+    const Column *materialized(size_t column) const
+    {
+        for (const std::unique_ptr<Column> &candidate : columns)
+        {
+            if (candidate->column != column)
+            {
+                continue;
+            }
+            Column &target = *candidate;
+            if (!target.ready.load(std::memory_order_acquire))
+            {
+                std::lock_guard<std::mutex> lock(target.mutex);
+                if (!target.ready.load(std::memory_order_relaxed))
+                {
+                    target.cells.resize(getRowCount());
+                    for (size_t row = 0; row < getRowCount(); ++row)
+                    {
+                        std::string_view cell;
+                        target.cells[row] = findCell(getLine(row), column, cell) ? cell : std::string_view();
+                    }
+                    target.ready.store(true, std::memory_order_release);
+                }
+            }
+            return &target;
+        }
+        return nullptr;
+    }
+
+public:
+    void addColumn(size_t column)
+    {
+        for (const std::unique_ptr<Column> &existing : columns)
+        {
+            if (existing->column == column)
+            {
+                return;
+            }
+        }
+        columns.push_back(std::make_unique<Column>(column));
+    }
+
+    // reads a whole file after the rows already there
+    bool read(const std::string &fileName)
+    {
+        TraceScope ioScope("io", "read ", fileName);
+        std::ifstream file(fileName, std::ios::binary);
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(fileName, error);
+        if (!file.is_open() || error)
+        {
+            return false;
+        }
+        if (!lineStarts.empty() && !text.empty() && text.back() != '\n')
+        {
+            text += '\n'; // the last line of the previous file
+        }
+        // the end of the last line + 1 is also where the lines of this file start
+        if (lineStarts.empty())
+        {
+            lineStarts.push_back(0);
+        }
+        // read in chunks so a step past its deadline or over its memory budget stops between two of them; the
+        // text grows and its lines are indexed chunk by chunk, so a file over the budget is not loaded whole
+        size_t start = text.size();
+        size_t end = start;
+        while (end - start < size && !CancellationToken::stopRequested() && !MemoryAccount::exceededBudget())
+        {
+            text.resize(end + static_cast<size_t>(std::min<uint64_t>(READ_CHUNK_SIZE, size - (end - start))));
+            file.read(&text[end], static_cast<std::streamsize>(text.size() - end));
+            if (file.gcount() <= 0)
+            {
+                break;
+            }
+            for (const char *found = text.data() + end, *last = found + file.gcount();
+                 (found = static_cast<const char *>(memchr(found, '\n', last - found))) != nullptr; ++found)
+            {
+                lineStarts.push_back(found - text.data() + 1);
+            }
+            end += static_cast<size_t>(file.gcount());
+        }
+        text.resize(end);
+        if (text.size() > start && text.back() != '\n')
+        {
+            lineStarts.push_back(text.size() + 1);
+        }
+        for (std::unique_ptr<Column> &column : columns)
+        {
+            column->ready = false;
+        }
+        return true;
+    }
+
+    // empties the table, keeping its capacity
+    void clear()
+    {
+        text.clear();
+        lineStarts.clear();
+        for (std::unique_ptr<Column> &column : columns)
+        {
+            column->cells.clear();
+            column->ready = false;
+        }
+    }
+
+    // clear that also frees the capacity
+    void release()
+    {
+        std::string().swap(text);
+        std::vector<size_t>().swap(lineStarts);
+        for (std::unique_ptr<Column> &column : columns)
+        {
+            std::vector<std::string_view>().swap(column->cells);
+            column->ready = false;
+        }
+    }
+
+    size_t getRowCount() const
+    {
+        return lineStarts.empty() ? 0 : lineStarts.size() - 1;
+    }
+
+    std::string_view getLine(size_t row) const
+    {
+        return std::string_view(text).substr(lineStarts[row], lineStarts[row + 1] - 1 - lineStarts[row]);
+    }
+
+    size_t getCellCount(size_t row) const
+    {
+        size_t count = 0;
+        forEachCell(row, [&count](std::string_view)
+                    { count++; });
+        return count;
+    }
+
+    bool hasCell(size_t row, size_t column) const
+    {
+        if (const Column *split = materialized(column))
+        {
+            return split->cells[row].data() != nullptr;
+        }
+        std::string_view cell;
+        return findCell(getLine(row), column, cell);
+    }
+
+    // the cell, or an empty string when the row has fewer columns
+    std::string_view getCell(size_t row, size_t column) const
+    {
+        if (const Column *split = materialized(column))
+        {
+            return split->cells[row];
+        }
+        std::string_view cell;
+        return findCell(getLine(row), column, cell) ? cell : std::string_view();
+    }
+
+    // calls visit(cell) for the cells of a row, in one pass over its line
+    template <typename Visit>
+    void forEachCell(size_t row, Visit &&visit) const
+    {
+        std::string_view line = getLine(row);
+        size_t start = 0;
+        while (start < line.size())
+        {
+            size_t end = line.find(',', start);
+            if (end == std::string_view::npos)
+            {
+                end = line.size();
+            }
+            visit(line.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+};
+
+// kind of index built over a CSV column
+enum class IndexKind
+{
+    Hash,  // equality lookups in O(1)
+    Sorted // equality and range lookups in O(log n)
+};
+
+// index over one column of a CSV file, mapping cell values to row numbers. It is saved in a sidecar
+// file next to the CSV, with the byte offset of every row, and reused as long as the CSV is the same file
+// (device, inode, size and modification and change times in nanoseconds). A valid sidecar lets the CSV
+// FILE INPUT step skip reading the CSV and read only the rows a lookup finds
+class CSVColumnIndex
+{
+private:
+    // sorted index entries: numeric values first (ordered as numbers), then text values (ordered as text)
+    struct SortedEntry
+    {
+        bool numeric;
+        double number;
+        std::string value;
+        size_t row;
+    };
+
+    // identity of the version of the source file; the change time cannot be set back by the user
+    struct SourceVersion
+    {
+        uint64_t size = 0;
+        int64_t modified = 0; // nanoseconds
+        int64_t changed = 0;  // nanoseconds, 0 where it is not known
+        uint64_t inode = 0;
+        uint64_t device = 0;
+
+        bool operator==(const SourceVersion &other) const
+        {
+            return size == other.size && modified == other.modified && changed == other.changed && inode == other.inode && device == other.device;
+        }
+    };
+
+    IndexKind kind;
+    size_t column;
+    std::unordered_map<std::string, std::vector<size_t>> hashIndex;
+    std::vector<SortedEntry> sortedIndex;
+    std::vector<uint64_t> rowOffsets; // byte offset of the line of every row, only known for a loaded sidecar
+
+    static constexpr uint32_t MAGIC = 0x58444943; // "CIDX"
+    static constexpr uint32_t VERSION = 2;
+
+    static bool lessThan(const SortedEntry &a, const SortedEntry &b)
+    {
+        if (a.numeric != b.numeric)
+        {
+            return a.numeric;
+        }
+        return a.numeric ? a.number < b.number : a.value < b.value;
+    }
+
+    static SortedEntry makeKey(const std::string &value)
+    {
+        SortedEntry key{false, 0.0, value, 0};
+        key.numeric = parseFiniteNumber(value, key.number);
+        return key;
+    }
+
+    // numbers are hashed by their value (the shortest text of the double), so a key finds the same cells
+    // as the numeric comparisons of the scan and of the sorted index, e.g. "1.0" finds "1"
+    static std::string hashKey(const std::string &value)
+    {
+        double number;
+        if (parseFiniteNumber(value, number))
+        {
+            return formatNumber(number == 0.0 ? 0.0 : number); // -0 equals 0
+        }
+        return value;
+    }
+
+    void insert(const std::string &value, size_t row)
+    {
+        if (kind == IndexKind::Hash)
+        {
+            hashIndex[hashKey(value)].push_back(row);
+        }
+        else
+        {
+            sortedIndex.push_back({false, 0.0, value, row});
+        }
+    }
+
+    void finishSortedIndex()
+    {
+        for (SortedEntry &entry : sortedIndex)
+        {
+            entry.numeric = parseFiniteNumber(entry.value, entry.number);
+        }
+        std::stable_sort(sortedIndex.begin(), sortedIndex.end(), lessThan);
+    }
+
+    static bool sourceVersion(const std::string &csvFile, SourceVersion &version)
+    {
+        version = SourceVersion();
+#ifdef __linux__
+        struct stat fileStat;
+        if (stat(csvFile.c_str(), &fileStat) != 0)
+        {
+            return false;
+        }
+        version.size = static_cast<uint64_t>(fileStat.st_size);
+        version.modified = static_cast<int64_t>(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+        version.changed = static_cast<int64_t>(fileStat.st_ctim.tv_sec) * 1000000000 + fileStat.st_ctim.tv_nsec;
+        version.inode = static_cast<uint64_t>(fileStat.st_ino);
+        version.device = static_cast<uint64_t>(fileStat.st_dev);
+        return true;
+#else
+        std::error_code error;
+        version.size = std::filesystem::file_size(csvFile, error);
+        if (error)
+        {
+            return false;
+        }
+        auto modified = std::filesystem::last_write_time(csvFile, error).time_since_epoch();
+        version.modified = std::chrono::duration_cast<std::chrono::nanoseconds>(modified).count();
+        return !error;
+#endif
+    }
+
+    // offsets of the lines of the file, the rows of CSVFileInputStep::readCSVFile (a last line without
+    // a newline is a row, the end of the file is not)
+    static bool lineOffsets(const std::string &csvFile, std::vector<uint64_t> &offsets)
+    {
+        std::ifstream file(csvFile, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        offsets.clear();
+        char buffer[64 * 1024];
+        uint64_t position = 0;
+        bool lineStart = true;
+        while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+        {
+            size_t count = static_cast<size_t>(file.gcount());
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (lineStart)
+                {
+                    offsets.push_back(position + i);
+                }
+                lineStart = buffer[i] == '\n';
+            }
+            position += count;
+        }
+        return true;
+    }
+
+    template <typename T>
+    static void writeValue(std::ostream &out, const T &value)
+    {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    static bool readValue(std::istream &in, T &value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+    }
+
+public:
+    CSVColumnIndex(IndexKind kind, size_t column) : kind(kind), column(column) {}
+
+    IndexKind getKind() const
+    {
+        return kind;
+    }
+
+    size_t getColumn() const
+    {
+        return column;
+    }
+
+    static std::string sidecarPath(const std::string &csvFile, IndexKind kind, size_t column)
+    {
+        return csvFile + ".col" + std::to_string(column) + (kind == IndexKind::Hash ? ".hash.idx" : ".sorted.idx");
+    }
+
+    // byte offset of the line of every row of the file, empty unless the index was loaded from its sidecar
+    const std::vector<uint64_t> &getRowOffsets() const
+    {
+        return rowOffsets;
+    }
+
+    // table: any type with getRowCount(), hasCell(row, column) and getCell(row, column)
+    template <typename Table>
+    void build(const Table &table)
+    {
+        hashIndex.clear();
+        sortedIndex.clear();
+        rowOffsets.clear();
+        for (size_t row = 0; row < table.getRowCount(); ++row)
+        {
+            if (table.hasCell(row, column))
+            {
+                insert(std::string(table.getCell(row, column)), row);
+            }
+        }
+        if (kind == IndexKind::Sorted)
+        {
+            finishSortedIndex();
+        }
+    }
+
+    // builds the index from the rows of the file and saves it in its sidecar, used when the sidecar is missing or stale
+    template <typename Table>
+    void buildAndSave(const std::string &csvFile, const Table &table)
+    {
+        std::string path = sidecarPath(csvFile, kind, column);
+        build(table);
+        if (!save(path, csvFile, table.getRowCount()))
+        {
+            std::cerr << "Warning: Unable to save index file '" << path << "'." << std::endl;
+        }
+    }
+
+    // rowCount: the rows the index was built from, false when the file no longer has as many lines
+    bool save(const std::string &path, const std::string &csvFile, size_t rowCount) const
+    {
+        SourceVersion source;
+        std::vector<uint64_t> offsets;
+        if (!sourceVersion(csvFile, source) || !lineOffsets(csvFile, offsets) || offsets.size() != rowCount)
+        {
+            return false;
+        }
+        TraceScope ioScope("io", "write ", path);
+        std::ofstream indexFile(path, std::ios::binary);
+        if (!indexFile.is_open())
+        {
+            return false;
+        }
+
+        // header, the offsets of the rows, then one (value, row) pair per indexed cell
+        writeValue(indexFile, MAGIC);
+        writeValue(indexFile, VERSION);
+        writeValue(indexFile, static_cast<uint32_t>(kind));
+        writeValue(indexFile, static_cast<uint64_t>(column));
+        writeValue(indexFile, source);
+        writeValue(indexFile, static_cast<uint64_t>(offsets.size()));
+        indexFile.write(reinterpret_cast<const char *>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+        auto writeEntry = [&indexFile](const std::string &value, size_t row)
+        {
+            writeValue(indexFile, static_cast<uint32_t>(value.size()));
+            indexFile.write(value.data(), static_cast<std::streamsize>(value.size()));
+            writeValue(indexFile, static_cast<uint64_t>(row));
+        };
+        if (kind == IndexKind::Hash)
+        {
+            uint64_t entryCount = 0;
+            for (const auto &entry : hashIndex)
+            {
+                entryCount += entry.second.size();
+            }
+            writeValue(indexFile, entryCount);
+            for (const auto &entry : hashIndex)
+            {
+                for (size_t row : entry.second)
+                {
+                    writeEntry(entry.first, row);
+                }
+            }
+        }
+        else
+        {
+            writeValue(indexFile, static_cast<uint64_t>(sortedIndex.size()));
+            for (const SortedEntry &entry : sortedIndex)
+            {
+                writeEntry(entry.value, entry.row);
+            }
+        }
+        return static_cast<bool>(indexFile);
+    }
+
+    // returns false when the sidecar is missing, corrupt or made for another version of the CSV file
+    bool load(const std::string &path, const std::string &csvFile)
+    {
+        SourceVersion source;
+        if (!sourceVersion(csvFile, source))
+        {
+            return false;
+        }
+        TraceScope ioScope("io", "read ", path);
+        std::ifstream indexFile(path, std::ios::binary);
+        uint32_t magic, version, storedKind;
+        uint64_t storedColumn, rowCount;
+        SourceVersion stored;
+        if (!indexFile.is_open() || !readValue(indexFile, magic) || !readValue(indexFile, version) || !readValue(indexFile, storedKind) ||
+            !readValue(indexFile, storedColumn) || !readValue(indexFile, stored) || !readValue(indexFile, rowCount))
+        {
+            return false;
+        }
+        // a row takes at least one byte of the file, which bounds the offsets before they are allocated
+        if (magic != MAGIC || version != VERSION || storedKind != static_cast<uint32_t>(kind) || storedColumn != column ||
+            !(stored == source) || rowCount > source.size)
+        {
+            return false;
+        }
+
+        hashIndex.clear();
+        sortedIndex.clear();
+        rowOffsets.resize(rowCount);
+        uint64_t entryCount;
+        if (!indexFile.read(reinterpret_cast<char *>(rowOffsets.data()), static_cast<std::streamsize>(rowCount * sizeof(uint64_t))) || !readValue(indexFile, entryCount))
+        {
+            rowOffsets.clear();
+            return false;
+        }
+        std::string value;
+        for (uint64_t i = 0; i < entryCount; ++i)
+        {
+            uint32_t length;
+            uint64_t row;
+            bool valid = readValue(indexFile, length) && length <= source.size;
+            if (valid)
+            {
+                value.resize(length);
+                valid = indexFile.read(&value[0], length) && readValue(indexFile, row) && row < rowCount;
+            }
+            if (!valid)
+            {
+                hashIndex.clear();
+                sortedIndex.clear();
+                rowOffsets.clear();
+                return false;
+            }
+            insert(value, static_cast<size_t>(row));
+        }
+        if (kind == IndexKind::Sorted)
+        {
+            finishSortedIndex();
+        }
+        return true;
+    }
+
+    // rows whose cell equals the key
+    std::vector<size_t> lookup(const std::string &key) const
+    {
+        if (kind == IndexKind::Hash)
+        {
+            auto found = hashIndex.find(hashKey(key));
+            return found != hashIndex.end() ? found->second : std::vector<size_t>();
+        }
+        return lookupRange(key, key);
+    }
+
+    // rows whose cell lies in [low, high]; only supported by sorted indexes
+    std::vector<size_t> lookupRange(const std::string &low, const std::string &high) const
+    {
+        if (kind != IndexKind::Sorted)
+        {
+            throw std::logic_error("Range lookups need a sorted index.");
+        }
+        SortedEntry lowKey = makeKey(low);
+        SortedEntry highKey = makeKey(high);
+        auto first = std::lower_bound(sortedIndex.begin(), sortedIndex.end(), lowKey, lessThan);
+        auto last = std::upper_bound(first, sortedIndex.end(), highKey, lessThan);
+        std::vector<size_t> rows;
+        rows.reserve(static_cast<size_t>(last - first));
+        for (auto it = first; it != last; ++it)
+        {
+            rows.push_back(it->row);
+        }
+        return rows;
+    }
+};
+
+// runs a batch of tasks on a pool of threads. Every worker owns a deque of task indices: it takes its own
+// tasks from the front (largest first) and, once it runs out, steals from the back of the other workers'
+// deques (smallest first), so a few big tasks do not leave the other workers idle
+class WorkStealingScheduler
+{
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    static bool takeTask(std::vector<WorkerQueue> &queues, size_t self, size_t &taskIndex)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[self].mutex);
+            if (!queues[self].tasks.empty())
+            {
+                taskIndex = queues[self].tasks.front();
+                queues[self].tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset)
+        {
+            WorkerQueue &victim = queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                taskIndex = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    // calls task(i) once for every i < costs.size(); costs estimate the work of every task (e.g. file sizes)
+    static void run(const std::vector<uint64_t> &costs, const std::function<void(size_t)> &task, size_t workerCount = std::thread::hardware_concurrency())
+    {
+        if (costs.empty())
+        {
+            return;
+        }
+        workerCount = std::max<size_t>(1, std::min(workerCount, costs.size()));
+
+        // deal the tasks round robin from the most to the least expensive
+        std::vector<size_t> order(costs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b)
+                         { return costs[a] > costs[b]; });
+        std::vector<WorkerQueue> queues(workerCount);
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            queues[i % workerCount].tasks.push_back(order[i]);
+        }
+
+        // the workers allocate on behalf of the account of the caller and stop with its step
+        MemoryAccount *account = MemoryAccount::getCurrent();
+        CancellationToken *token = CancellationToken::current;
+        auto worker = [&queues, &task, account, token](size_t self)
+        {
+            MemoryAccountScope memoryScope(account);
+            CancellationScope cancellationScope(token);
+            size_t taskIndex;
+            while (takeTask(queues, self, taskIndex))
+            {
+                task(taskIndex);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t self = 1; self < workerCount; ++self)
+        {
+            threads.emplace_back(worker, self);
+        }
+        worker(0);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+};
+
+enum class ColumnType : uint8_t
+{
+    Int64 = 1,
+    Float64 = 2,
+    String = 3
+};
+
+enum class ColumnEncoding : uint8_t
+{
+    Plain = 0,     // one value per row: 8 bytes, the difference to the block min in 1, 2 or 4 bytes for int64, or
+                   // for strings the offsets of the values then their bytes
+    RunLength = 1, // numbers: runs of equal values, each with the row after its end
+    Dictionary = 2 // strings: the distinct values once, then an id per row
+};
+
+// columnar file: the header, one ColumnarColumnHeader per column, one ColumnarBlockHeader per block and
+// column (the columns of block 0, then those of block 1...), the column names, then the blocks. All the
+// fields are in native byte order (the values narrower than 8 bytes in little endian) and every block
+// starts at a multiple of 8, so a mapped file is read in place, without parsing
+struct ColumnarFileHeader
+{
+    char magic[8]; // "FLOWCOL1"
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rowCount; // rows stored in the blocks, the row of column names not included
+    uint32_t rowsPerBlock;
+    uint32_t hasNames; // 1 when the first row of the table holds the column names
+};
+static_assert(sizeof(ColumnarFileHeader) == 32, "ColumnarFileHeader is stored as is");
+
+struct ColumnarColumnHeader
+{
+    uint8_t type;    // ColumnType
+    uint8_t hasName; // the row of names has a cell for this column
+    uint16_t reserved;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+};
+static_assert(sizeof(ColumnarColumnHeader) == 16, "ColumnarColumnHeader is stored as is");
+
+struct ColumnarBlockHeader
+{
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+    uint32_t rowCount;
+    uint8_t encoding; // ColumnEncoding
+    uint8_t width;    // bytes per id of a dictionary block or per value of a plain numeric block
+    uint8_t hasNulls; // the block starts with a bitmap of the rows that have the cell
+    uint8_t hasStats; // 0 when no row of the block has the cell
+    uint64_t min;     // bits of the int64 or double; for strings the row of the block holding the smallest value
+    uint64_t max;
+};
+static_assert(sizeof(ColumnarBlockHeader) == 40, "ColumnarBlockHeader is stored as is");
+
+// a table written by ColumnarWriter, mapped in memory. It answers the same calls as the other tables of a
+// CSV FILE INPUT step and gives back exactly the cells that were written: the cells of a numeric column are
+// stored as numbers only when they are the shortest text of their number. Such a column is turned back
+// into text on its first getCell, getNumber reads the numbers directly
+class ColumnarTable
+{
+private:
+    struct NumericText
+    {
+        std::mutex mutex;
+        std::atomic<bool> ready{false};
+        std::string text;
+        std::vector<uint64_t> ends; // end of the text of every row, it starts at the end of the previous one
+    };
+
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef __linux__
+    void *mapped = nullptr;
+#else
+    std::vector<char> contents;
+#endif
+    ColumnarFileHeader header{};
+    size_t firstRow = 0; // 1 when row 0 is the row of column names
+    std::vector<ColumnarColumnHeader> columns;
+    std::vector<ColumnarBlockHeader> blocks;
+    std::vector<std::unique_ptr<NumericText>> texts;
+
+    template <typename T>
+    T load(uint64_t offset) const
+    {
+        T value;
+        memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    static uint64_t align(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // bytes of the null bitmap at the start of a block, padded to 8
+    static uint64_t bitmapSize(uint64_t rowCount)
+    {
+        return align((rowCount + 7) / 8, 8);
+    }
+
+    const ColumnarBlockHeader &findBlock(size_t row, size_t column, size_t &relative) const
+    {
+        size_t dataRow = row - firstRow;
+        size_t block = dataRow / header.rowsPerBlock;
+        relative = dataRow - block * header.rowsPerBlock;
+        return blocks[block * columns.size() + column];
+    }
+
+    static uint64_t valuesOffset(const ColumnarBlockHeader &block)
+    {
+        return block.offset + (block.hasNulls ? bitmapSize(block.rowCount) : 0);
+    }
+
+    bool present(const ColumnarBlockHeader &block, size_t relative) const
+    {
+        return !block.hasNulls || (static_cast<unsigned char>(data[block.offset + relative / 8]) >> (relative % 8)) & 1;
+    }
+
+    uint64_t numberBits(const ColumnarBlockHeader &block, size_t relative) const
+    {
+        uint64_t values = valuesOffset(block);
+        if (block.encoding == static_cast<uint8_t>(ColumnEncoding::Plain) && block.width == 8)
+        {
+            return load<uint64_t>(values + relative * 8);
+        }
+        if (block.encoding == static_cast<uint8_t>(ColumnEncoding::Plain))
+        {
+            uint64_t difference = 0;
+            memcpy(&difference, data + values + relative * block.width, block.width);
+            return block.min + difference;
+        }
+        // runs of 16 bytes: the value, then the row after the end of the run
+        size_t low = 0, high = load<uint32_t>(values);
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (load<uint32_t>(values + 8 + middle * 16 + 8) <= relative)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return load<uint64_t>(values + 8 + low * 16);
+    }
+
+    std::string_view stringValue(const ColumnarBlockHeader &block, size_t relative) const
+    {
+        uint64_t values = valuesOffset(block);
+        uint64_t offsets = values;
+        uint64_t count = block.rowCount;
+        size_t index = relative;
+        if (block.encoding == static_cast<uint8_t>(ColumnEncoding::Dictionary))
+        {
+            count = load<uint32_t>(values);
+            offsets = values + 8;
+            uint64_t ids = align(offsets + 4 * (count + 1) + load<uint32_t>(offsets + 4 * count), 4);
+            index = block.width == 1 ? load<uint8_t>(ids + relative) : (block.width == 2 ? load<uint16_t>(ids + relative * 2) : load<uint32_t>(ids + relative * 4));
+            if (index >= count)
+            {
+                return std::string_view();
+            }
+        }
+        uint64_t bytes = offsets + 4 * (count + 1);
+        uint32_t start = load<uint32_t>(offsets + 4 * index);
+        uint32_t end = load<uint32_t>(offsets + 4 * (index + 1));
+        if (start > end || bytes + end > block.offset + block.size)
+        {
+            return std::string_view();
+        }
+        return std::string_view(data + bytes + start, end - start);
+    }
+
+    std::string formatBits(ColumnType type, uint64_t bits) const
+    {
+        if (type == ColumnType::Int64)
+        {
+            int64_t number;
+            memcpy(&number, &bits, 8);
+            return formatNumber(number);
+        }
+        double number;
+        memcpy(&number, &bits, 8);
+        return formatNumber(number);
+    }
+
+    // the text of a numeric column, made on the first call
+    const NumericText &numericText(size_t column) const
+    {
+        NumericText &target = *texts[column];
+        if (!target.ready.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(target.mutex);
+            if (!target.ready.load(std::memory_order_relaxed))
+            {
+                ColumnType type = static_cast<ColumnType>(columns[column].type);
+                target.ends.resize(header.rowCount);
+                for (size_t row = 0; row < header.rowCount; ++row)
+                {
+                    size_t relative;
+                    const ColumnarBlockHeader &block = findBlock(row + firstRow, column, relative);
+                    if (present(block, relative))
+                    {
+                        uint64_t bits = numberBits(block, relative);
+                        if (type == ColumnType::Int64)
+                        {
+                            int64_t number;
+                            memcpy(&number, &bits, 8);
+                            appendNumber(target.text, number);
+                        }
+                        else
+                        {
+                            double number;
+                            memcpy(&number, &bits, 8);
+                            appendNumber(target.text, number);
+                        }
+                    }
+                    target.ends[row] = target.text.size();
+                }
+                target.ready.store(true, std::memory_order_release);
+            }
+        }
+        return target;
+    }
+
+    // checks that every header and block lies inside the file, so the accesses need no further checks
+    bool validate()
+    {
+        if (size < sizeof(ColumnarFileHeader))
+        {
+            return false;
+        }
+        header = load<ColumnarFileHeader>(0);
+        if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.rowsPerBlock == 0)
+        {
+            return false;
+        }
+        // without columns no block bounds the rows, so such a file must have none
+        if (header.columnCount == 0 && header.rowCount != 0)
+        {
+            return false;
+        }
+        // the counts come from the file: bound them by its size before multiplying, so no product wraps
+        uint64_t blockCount = header.rowCount / header.rowsPerBlock + (header.rowCount % header.rowsPerBlock != 0);
+        if (header.columnCount > size / sizeof(ColumnarColumnHeader) ||
+            (header.columnCount != 0 && blockCount > size / sizeof(ColumnarBlockHeader) / header.columnCount))
+        {
+            return false;
+        }
+        uint64_t directoryEnd = sizeof(ColumnarFileHeader) + uint64_t{header.columnCount} * sizeof(ColumnarColumnHeader) +
+                                blockCount * header.columnCount * sizeof(ColumnarBlockHeader);
+        if (directoryEnd > size)
+        {
+            return false;
+        }
+        firstRow = header.hasNames ? 1 : 0;
+        columns.resize(header.columnCount);
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            columns[column] = load<ColumnarColumnHeader>(sizeof(ColumnarFileHeader) + column * sizeof(ColumnarColumnHeader));
+            const ColumnarColumnHeader &columnHeader = columns[column];
+            if (columnHeader.type < static_cast<uint8_t>(ColumnType::Int64) || columnHeader.type > static_cast<uint8_t>(ColumnType::String) || columnHeader.nameOffset > size || columnHeader.nameLength > size - columnHeader.nameOffset)
+            {
+                return false;
+            }
+        }
+
+        blocks.resize(blockCount * header.columnCount);
+        uint64_t directory = sizeof(ColumnarFileHeader) + header.columnCount * sizeof(ColumnarColumnHeader);
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            blocks[i] = load<ColumnarBlockHeader>(directory + i * sizeof(ColumnarBlockHeader));
+            const ColumnarBlockHeader &block = blocks[i];
+            uint64_t firstBlockRow = i / header.columnCount * header.rowsPerBlock;
+            ColumnType type = static_cast<ColumnType>(columns[i % header.columnCount].type);
+            if (block.offset % 8 != 0 || block.offset > size || block.size > size - block.offset ||
+                block.rowCount != std::min<uint64_t>(header.rowsPerBlock, header.rowCount - firstBlockRow))
+            {
+                return false;
+            }
+            uint64_t values = valuesOffset(block);
+            uint64_t end = block.offset + block.size;
+            uint64_t needed;
+            if (type != ColumnType::String && block.encoding == static_cast<uint8_t>(ColumnEncoding::Plain) &&
+                (block.width == 8 || (type == ColumnType::Int64 && (block.width == 1 || block.width == 2 || block.width == 4))))
+            {
+                needed = values + uint64_t{block.rowCount} * block.width;
+            }
+            else if (type != ColumnType::String && block.encoding == static_cast<uint8_t>(ColumnEncoding::RunLength))
+            {
+                needed = values + 8;
+                if (needed <= end)
+                {
+                    uint64_t runCount = load<uint32_t>(values);
+                    needed += runCount * 16;
+                    // the last run ends with the block, so every row is in a run
+                    if (runCount == 0 || (needed <= end && load<uint32_t>(values + 8 + (runCount - 1) * 16 + 8) != block.rowCount))
+                    {
+                        return false;
+                    }
+                }
+            }
+            else if (type == ColumnType::String && block.encoding == static_cast<uint8_t>(ColumnEncoding::Plain))
+            {
+                needed = values + 4 * (uint64_t{block.rowCount} + 1);
+                if (needed <= end)
+                {
+                    needed += load<uint32_t>(values + 4 * uint64_t{block.rowCount});
+                }
+            }
+            else if (type == ColumnType::String && block.encoding == static_cast<uint8_t>(ColumnEncoding::Dictionary) &&
+                     (block.width == 1 || block.width == 2 || block.width == 4))
+            {
+                needed = values + 8;
+                if (needed <= end)
+                {
+                    uint64_t count = load<uint32_t>(values);
+                    needed += 4 * (count + 1);
+                    if (needed <= end)
+                    {
+                        needed = align(needed + load<uint32_t>(values + 8 + 4 * count), 4) + uint64_t{block.rowCount} * block.width;
+                    }
+                }
+            }
+            else
+            {
+                return false;
+            }
+            if (needed > end || values > end || (type == ColumnType::String && block.hasStats && (block.min >= block.rowCount || block.max >= block.rowCount)))
+            {
+                return false;
+            }
+        }
+
+        texts.clear();
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            texts.push_back(std::make_unique<NumericText>());
+        }
+        return true;
+    }
+
+public:
+    static constexpr char MAGIC[8] = {'F', 'L', 'O', 'W', 'C', 'O', 'L', '1'};
+    static constexpr uint32_t VERSION = 1;
+
+    ColumnarTable() = default;
+    ColumnarTable(const ColumnarTable &) = delete;
+    ColumnarTable &operator=(const ColumnarTable &) = delete;
+
+    ~ColumnarTable()
+    {
+        close();
+    }
+
+    // true when the file starts with the magic of a columnar file
+    static bool isColumnarFile(const std::string &fileName)
+    {
+        char magic[sizeof(MAGIC)];
+        std::ifstream file;
+        file.rdbuf()->pubsetbuf(readBuffer.data(), readBuffer.size());
+        file.open(fileName, std::ios::binary);
+        return file.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    // maps the file; false when it cannot be read or is not a valid columnar file
+    bool open(const std::string &fileName)
+    {
+        close();
+        TraceScope ioScope("io", "map ", fileName);
+#ifdef __linux__
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        size = static_cast<size_t>(status.st_size);
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            mapped = nullptr;
+            size = 0;
+            return false;
+        }
+        data = static_cast<const char *>(mapped);
+#else
+        std::ifstream file(fileName, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data = contents.data();
+        size = contents.size();
+#endif
+        if (!validate())
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+#ifdef __linux__
+        if (mapped)
+        {
+            munmap(mapped, size);
+            mapped = nullptr;
+        }
+#else
+        std::vector<char>().swap(contents);
+#endif
+        data = nullptr;
+        size = 0;
+        header = ColumnarFileHeader{};
+        firstRow = 0;
+        columns.clear();
+        blocks.clear();
+        texts.clear();
+    }
+
+    size_t getRowCount() const
+    {
+        return data ? firstRow + header.rowCount : 0;
+    }
+
+    size_t getColumnCount() const
+    {
+        return columns.size();
+    }
+
+    ColumnType getColumnType(size_t column) const
+    {
+        return static_cast<ColumnType>(columns[column].type);
+    }
+
+    size_t getBlockCount() const
+    {
+        return columns.empty() ? 0 : blocks.size() / columns.size();
+    }
+
+    // the encoding and statistics of a block of a column
+    const ColumnarBlockHeader &getBlock(size_t block, size_t column) const
+    {
+        return blocks[block * columns.size() + column];
+    }
+
+    bool hasCell(size_t row, size_t column) const
+    {
+        if (column >= columns.size())
+        {
+            return false;
+        }
+        if (row < firstRow)
+        {
+            return columns[column].hasName != 0;
+        }
+        size_t relative;
+        const ColumnarBlockHeader &block = findBlock(row, column, relative);
+        return present(block, relative);
+    }
+
+    // the cells of a row are the columns up to the last one it has
+    size_t getCellCount(size_t row) const
+    {
+        for (size_t column = columns.size(); column > 0; --column)
+        {
+            if (hasCell(row, column - 1))
+            {
+                return column;
+            }
+        }
+        return 0;
+    }
+
+    // the cell, or an empty string when the row has no such cell
+    std::string_view getCell(size_t row, size_t column) const
+    {
+        if (!hasCell(row, column))
+        {
+            return std::string_view();
+        }
+        if (row < firstRow)
+        {
+            return std::string_view(data + columns[column].nameOffset, columns[column].nameLength);
+        }
+        if (getColumnType(column) == ColumnType::String)
+        {
+            size_t relative;
+            const ColumnarBlockHeader &block = findBlock(row, column, relative);
+            return stringValue(block, relative);
+        }
+        const NumericText &text = numericText(column);
+        size_t dataRow = row - firstRow;
+        size_t start = dataRow > 0 ? text.ends[dataRow - 1] : 0;
+        return std::string_view(text.text).substr(start, text.ends[dataRow] - start);
+    }
+
+    // the cell as a number, read as stored for a numeric column; false when the cell is missing or not numeric
+    bool getNumber(size_t row, size_t column, double &number) const
+    {
+        if (row < firstRow || column >= columns.size() || getColumnType(column) == ColumnType::String)
+        {
+            return hasCell(row, column) && parseFiniteNumber(getCell(row, column), number);
+        }
+        size_t relative;
+        const ColumnarBlockHeader &block = findBlock(row, column, relative);
+        if (!present(block, relative))
+        {
+            return false;
+        }
+        uint64_t bits = numberBits(block, relative);
+        if (getColumnType(column) == ColumnType::Int64)
+        {
+            int64_t value;
+            memcpy(&value, &bits, 8);
+            number = static_cast<double>(value);
+        }
+        else
+        {
+            memcpy(&number, &bits, 8);
+        }
+        return std::isfinite(number); // the writer stores none, a damaged file could
+    }
+
+    // rows whose cell lies in [low, high], compared as numbers when both the cell and the bounds are numeric,
+    // as text otherwise. Blocks whose min and max are outside the range are skipped without being read
+    std::vector<size_t> findRows(size_t column, const std::string &low, const std::string &high) const
+    {
+        std::vector<size_t> rows;
+        double lowNumber, highNumber, number;
+        bool numericRange = parseFiniteNumber(low, lowNumber) && parseFiniteNumber(high, highNumber);
+        auto inRange = [&](size_t row)
+        {
+            if (numericRange && getNumber(row, column, number))
+            {
+                return number >= lowNumber && number <= highNumber;
+            }
+            std::string_view cell = getCell(row, column);
+            return cell >= low && cell <= high;
+        };
+        for (size_t row = 0; row < firstRow; ++row)
+        {
+            if (hasCell(row, column) && inRange(row))
+            {
+                rows.push_back(row);
+            }
+        }
+        if (column >= columns.size())
+        {
+            return rows;
+        }
+
+        ColumnType type = getColumnType(column);
+        for (size_t blockIndex = 0; blockIndex < getBlockCount(); ++blockIndex)
+        {
+            CancellationToken::checkpoint();
+            const ColumnarBlockHeader &block = getBlock(blockIndex, column);
+            if (!block.hasStats)
+            {
+                continue; // no row of the block has the cell
+            }
+            // numeric columns against a numeric range and text columns against a text range compare every
+            // cell the same way, so the min and max of the block decide whether it can hold a match
+            if (type != ColumnType::String && numericRange)
+            {
+                double min, max;
+                if (type == ColumnType::Int64)
+                {
+                    int64_t value;
+                    memcpy(&value, &block.min, 8);
+                    min = static_cast<double>(value);
+                    memcpy(&value, &block.max, 8);
+                    max = static_cast<double>(value);
+                }
+                else
+                {
+                    memcpy(&min, &block.min, 8);
+                    memcpy(&max, &block.max, 8);
+                }
+                if (max < lowNumber || min > highNumber)
+                {
+                    continue;
+                }
+            }
+            else if (type == ColumnType::String && !numericRange && (stringValue(block, block.max) < low || stringValue(block, block.min) > high))
+            {
+                continue;
+            }
+
+            size_t begin = firstRow + blockIndex * header.rowsPerBlock;
+            for (size_t row = begin; row < begin + block.rowCount; ++row)
+            {
+                if (present(block, row - begin) && inRange(row))
+                {
+                    rows.push_back(row);
+                }
+            }
+        }
+        return rows;
+    }
+
+    // min and max of a block as text, empty when no row of the block has the cell
+    std::pair<std::string, std::string> getBlockStats(size_t block, size_t column) const
+    {
+        const ColumnarBlockHeader &stats = getBlock(block, column);
+        if (!stats.hasStats)
+        {
+            return {};
+        }
+        ColumnType type = getColumnType(column);
+        if (type == ColumnType::String)
+        {
+            return {std::string(stringValue(stats, stats.min)), std::string(stringValue(stats, stats.max))};
+        }
+        return {formatBits(type, stats.min), formatBits(type, stats.max)};
+    }
+};
+
+// writes a table in the columnar format. Every column gets the narrowest type that gives back its cells
+// exactly (int64, double, else string), then the rows are cut in blocks of ROWS_PER_BLOCK; every block
+// of a column holds its min and max and is stored run length (numbers) or dictionary (strings) encoded
+// when that is smaller than the plain values. Table is any type with getRowCount() and forEachCell(row, visit)
+class ColumnarWriter
+{
+private:
+    static constexpr uint32_t ROWS_PER_BLOCK = 65536;
+
+    struct BlockCells
+    {
+        std::vector<std::string_view> cells;
+        std::vector<uint8_t> present;
+    };
+
+    struct ColumnTypes
+    {
+        bool integers = true; // every cell is the shortest text of an int64
+        bool numbers = true;  // every cell is the shortest text of a finite double
+    };
+
+    // the number of a cell, only when formatting the number gives back exactly the same text
+    template <typename T>
+    static bool exactNumber(std::string_view cell, T &number)
+    {
+        if (!parseNumber(cell, number))
+        {
+            return false;
+        }
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (!std::isfinite(number))
+            {
+                return false;
+            }
+        }
+        char buffer[64];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+        return std::string_view(buffer, result.ptr - buffer) == cell;
+    }
+
+    template <typename T>
+    static void appendRaw(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    static void pad(std::string &out, size_t alignment)
+    {
+        out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+    }
+
+    static void appendBitmap(std::string &out, const std::vector<uint8_t> &present)
+    {
+        size_t start = out.size();
+        out.resize(start + (present.size() + 7) / 8, '\0');
+        for (size_t row = 0; row < present.size(); ++row)
+        {
+            if (present[row])
+            {
+                out[start + row / 8] |= static_cast<char>(1 << (row % 8));
+            }
+        }
+        pad(out, 8);
+    }
+
+    template <typename T>
+    static void encodeNumbers(const BlockCells &cells, ColumnarBlockHeader &block, std::string &out)
+    {
+        std::vector<uint64_t> bits(cells.cells.size(), 0);
+        T min = 0, max = 0;
+        for (size_t row = 0; row < cells.cells.size(); ++row)
+        {
+            T number;
+            if (!cells.present[row] || !exactNumber(cells.cells[row], number))
+            {
+                continue;
+            }
+            memcpy(&bits[row], &number, 8);
+            min = block.hasStats ? std::min(min, number) : number;
+            max = block.hasStats ? std::max(max, number) : number;
+            block.hasStats = 1;
+        }
+        memcpy(&block.min, &min, 8);
+        memcpy(&block.max, &max, 8);
+
+        size_t runCount = 0;
+        for (size_t row = 0; row < bits.size(); ++row)
+        {
+            runCount += row == 0 || bits[row] != bits[row - 1];
+        }
+        if (8 + runCount * 16 < bits.size() * 8)
+        {
+            block.encoding = static_cast<uint8_t>(ColumnEncoding::RunLength);
+            appendRaw(out, static_cast<uint32_t>(runCount));
+            appendRaw(out, static_cast<uint32_t>(0));
+            for (size_t row = 0; row < bits.size(); ++row)
+            {
+                if (row + 1 == bits.size() || bits[row + 1] != bits[row])
+                {
+                    appendRaw(out, bits[row]);
+                    appendRaw(out, static_cast<uint32_t>(row + 1));
+                    appendRaw(out, static_cast<uint32_t>(0));
+                }
+            }
+        }
+        else if (std::is_integral<T>::value && block.max - block.min <= 0xFFFFFFFF)
+        {
+            // frame of reference: the difference to the block min, in as few bytes as the range of the block needs
+            uint64_t range = block.max - block.min;
+            block.encoding = static_cast<uint8_t>(ColumnEncoding::Plain);
+            block.width = range <= 0xFF ? 1 : (range <= 0xFFFF ? 2 : 4);
+            for (size_t row = 0; row < bits.size(); ++row)
+            {
+                uint64_t difference = cells.present[row] ? bits[row] - block.min : 0;
+                out.append(reinterpret_cast<const char *>(&difference), block.width); // little endian: the low bytes first
+            }
+        }
+        else
+        {
+            block.encoding = static_cast<uint8_t>(ColumnEncoding::Plain);
+            block.width = 8;
+            out.append(reinterpret_cast<const char *>(bits.data()), bits.size() * 8);
+        }
+    }
+
+    static bool encodeStrings(const BlockCells &cells, ColumnarBlockHeader &block, std::string &out)
+    {
+        size_t rowCount = cells.cells.size();
+        size_t bytes = 0;
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::vector<std::string_view> distinct;
+        size_t distinctBytes = 0;
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            std::string_view cell = cells.cells[row];
+            bytes += cell.size();
+            if (ids.emplace(cell, static_cast<uint32_t>(distinct.size())).second)
+            {
+                distinct.push_back(cell);
+                distinctBytes += cell.size();
+            }
+            if (cells.present[row])
+            {
+                if (!block.hasStats || cell < cells.cells[block.min])
+                {
+                    block.min = row;
+                }
+                if (!block.hasStats || cell > cells.cells[block.max])
+                {
+                    block.max = row;
+                }
+                block.hasStats = 1;
+            }
+        }
+        if (bytes > std::numeric_limits<uint32_t>::max())
+        {
+            return false; // the offsets of a block are 32 bits
+        }
+
+        uint8_t idWidth = distinct.size() <= 256 ? 1 : (distinct.size() <= 65536 ? 2 : 4);
+        size_t plainSize = 4 * (rowCount + 1) + bytes;
+        size_t dictionarySize = 8 + 4 * (distinct.size() + 1) + distinctBytes + 3 + rowCount * idWidth;
+        const std::vector<std::string_view> &values = dictionarySize < plainSize ? distinct : cells.cells;
+        if (dictionarySize < plainSize)
+        {
+            block.encoding = static_cast<uint8_t>(ColumnEncoding::Dictionary);
+            block.width = idWidth;
+            appendRaw(out, static_cast<uint32_t>(distinct.size()));
+            appendRaw(out, static_cast<uint32_t>(0));
+        }
+        else
+        {
+            block.encoding = static_cast<uint8_t>(ColumnEncoding::Plain);
+        }
+        uint32_t offset = 0;
+        appendRaw(out, offset);
+        for (std::string_view value : values)
+        {
+            offset += static_cast<uint32_t>(value.size());
+            appendRaw(out, offset);
+        }
+        for (std::string_view value : values)
+        {
+            out.append(value);
+        }
+        if (block.encoding == static_cast<uint8_t>(ColumnEncoding::Dictionary))
+        {
+            pad(out, 4);
+            for (std::string_view cell : cells.cells)
+            {
+                uint32_t id = ids[cell];
+                out.append(reinterpret_cast<const char *>(&id), idWidth); // little endian: the low bytes first
+            }
+        }
+        return true;
+    }
+
+    template <typename Table>
+    static bool writeFile(const std::string &fileName, const Table &table, bool firstRowNames)
+    {
+        size_t firstRow = firstRowNames && table.getRowCount() > 0 ? 1 : 0;
+        uint64_t rowCount = table.getRowCount() - firstRow;
+
+        // first pass: the columns and their types
+        std::vector<ColumnTypes> types;
+        for (size_t row = 0; row < table.getRowCount(); ++row)
+        {
+            CancellationToken::checkpoint();
+            size_t column = 0;
+            table.forEachCell(row, [&](std::string_view cell)
+                              {
+                if (column == types.size())
+                {
+                    types.emplace_back();
+                }
+                ColumnTypes &type = types[column++];
+                int64_t integer;
+                double number;
+                if (row >= firstRow)
+                {
+                    type.integers = type.integers && exactNumber(cell, integer);
+                    type.numbers = type.numbers && exactNumber(cell, number);
+                } });
+        }
+        // rows without cells are kept as one column with every cell missing: a file with rows has columns
+        if (types.empty() && rowCount > 0)
+        {
+            types.emplace_back();
+        }
+
+        ColumnarFileHeader header{};
+        memcpy(header.magic, ColumnarTable::MAGIC, sizeof(header.magic));
+        header.version = ColumnarTable::VERSION;
+        header.columnCount = static_cast<uint32_t>(types.size());
+        header.rowCount = rowCount;
+        header.rowsPerBlock = ROWS_PER_BLOCK;
+        header.hasNames = firstRow;
+        size_t blockCount = (rowCount + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+        std::vector<ColumnarColumnHeader> columns(types.size());
+        std::vector<ColumnarBlockHeader> blocks(blockCount * types.size());
+        uint64_t offset = sizeof(header) + columns.size() * sizeof(ColumnarColumnHeader) + blocks.size() * sizeof(ColumnarBlockHeader);
+
+        std::string names;
+        for (size_t column = 0; column < types.size(); ++column)
+        {
+            columns[column].type = static_cast<uint8_t>(types[column].integers ? ColumnType::Int64 : (types[column].numbers ? ColumnType::Float64 : ColumnType::String));
+        }
+        if (firstRow)
+        {
+            size_t column = 0;
+            table.forEachCell(0, [&](std::string_view cell)
+                              {
+                columns[column].hasName = 1;
+                columns[column].nameLength = static_cast<uint32_t>(cell.size());
+                columns[column++].nameOffset = offset + names.size();
+                names.append(cell); });
+        }
+        pad(names, 8);
+        offset += names.size();
+
+        std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        // the headers are written last, once the blocks are placed: until then the file has no magic
+        std::string directory(sizeof(header) + columns.size() * sizeof(ColumnarColumnHeader) + blocks.size() * sizeof(ColumnarBlockHeader), '\0');
+        file.write(directory.data(), directory.size());
+        file.write(names.data(), names.size());
+
+        std::vector<BlockCells> blockCells(types.size());
+        std::string out;
+        for (size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+        {
+            CancellationToken::checkpoint();
+            size_t begin = firstRow + blockIndex * ROWS_PER_BLOCK;
+            size_t end = std::min<size_t>(begin + ROWS_PER_BLOCK, table.getRowCount());
+            for (BlockCells &cells : blockCells)
+            {
+                cells.cells.assign(end - begin, std::string_view());
+                cells.present.assign(end - begin, 0);
+            }
+            for (size_t row = begin; row < end; ++row)
+            {
+                size_t column = 0;
+                table.forEachCell(row, [&](std::string_view cell)
+                                  {
+                    blockCells[column].cells[row - begin] = cell;
+                    blockCells[column++].present[row - begin] = 1; });
+            }
+
+            for (size_t column = 0; column < types.size(); ++column)
+            {
+                const BlockCells &cells = blockCells[column];
+                ColumnarBlockHeader &block = blocks[blockIndex * types.size() + column];
+                block.offset = offset;
+                block.rowCount = static_cast<uint32_t>(end - begin);
+                block.hasNulls = std::find(cells.present.begin(), cells.present.end(), 0) != cells.present.end();
+                out.clear();
+                if (block.hasNulls)
+                {
+                    appendBitmap(out, cells.present);
+                }
+                ColumnType type = static_cast<ColumnType>(columns[column].type);
+                if (type == ColumnType::Int64)
+                {
+                    encodeNumbers<int64_t>(cells, block, out);
+                }
+                else if (type == ColumnType::Float64)
+                {
+                    encodeNumbers<double>(cells, block, out);
+                }
+                else if (!encodeStrings(cells, block, out))
+                {
+                    return false;
+                }
+                block.size = out.size();
+                pad(out, 8);
+                file.write(out.data(), out.size());
+                offset += out.size();
+            }
+        }
+
+        size_t position = 0;
+        memcpy(&directory[position], &header, sizeof(header));
+        position += sizeof(header);
+        memcpy(&directory[position], columns.data(), columns.size() * sizeof(ColumnarColumnHeader));
+        position += columns.size() * sizeof(ColumnarColumnHeader);
+        memcpy(&directory[position], blocks.data(), blocks.size() * sizeof(ColumnarBlockHeader));
+        file.seekp(0);
+        file.write(directory.data(), directory.size());
+        file.close();
+        return !file.fail();
+    }
+
+public:
+    // false when the file cannot be written; firstRowNames stores the first row as the column names
+    template <typename Table>
+    static bool write(const std::string &fileName, const Table &table, bool firstRowNames)
+    {
+        TraceScope ioScope("io", "write ", fileName);
+        // written beside the target and renamed over it: the target may be the file a CSV FILE INPUT
+        // step has mapped, and truncating it would pull the pages from under the mapping
+        std::string temporary = fileName + ".tmp";
+        std::error_code error;
+        bool written;
+        try
+        {
+            written = writeFile(temporary, table, firstRowNames);
+        }
+        catch (...)
+        {
+            std::filesystem::remove(temporary, error);
+            throw;
+        }
+        if (written)
+        {
+            std::filesystem::rename(temporary, fileName, error);
+        }
+        if (!written || error)
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+};
+
+// rows of text held in memory, as a table for ColumnarWriter
+class RowTable
+{
+private:
+    const std::vector<std::vector<std::string>> &rows;
+
+public:
+    explicit RowTable(const std::vector<std::vector<std::string>> &rows) : rows(rows) {}
+
+    size_t getRowCount() const
+    {
+        return rows.size();
+    }
+
+    template <typename Visit>
+    void forEachCell(size_t row, Visit &&visit) const
+    {
+        for (const std::string &cell : rows[row])
+        {
+            visit(std::string_view(cell));
+        }
+    }
+};
+
+class CSVFileInputStep : public Step
+{
+private:
+    std::string description;
+    std::string file_name;
+    std::filesystem::path inputPath; // file_name parsed once, not on every run
+    std::vector<std::vector<std::string>> csvData; // rows as read, empty when the table is dictionary encoded
+    std::unique_ptr<DictionaryTable> encodedData;  // rows as ids of a string pool, set by setDictionaryEncoding
+    std::unique_ptr<RawCSVTable> rawData;          // raw lines, set once the consumers declare their columns
+    std::unique_ptr<ColumnarTable> columnarData;   // mapped file, set when the input is a columnar file
+    ObjectPool<std::vector<std::string>> rowPool;  // rows of the previous run, refilled by the next one
+    std::vector<CSVColumnIndex> indexes;           // column indexes, loaded before every read or rebuilt after it
+    bool deterministicOrder;                       // several files: merge them in path order instead of completion order
+    bool allRowsRequired = false;                  // a consumer reads every row, so the file is always read
+
+    // set when every index was loaded from a valid sidecar and no consumer reads every row: the file is not
+    // read, a row is read at the offset the index gives on its first access and kept for the next ones
+    size_t lazyIndex = std::string::npos;
+    mutable std::mutex lazyMutex;
+    mutable std::ifstream lazyFile;
+    mutable std::unordered_map<size_t, std::vector<std::string>> lazyRows;
+
+    bool readsLazily() const
+    {
+        return lazyIndex != std::string::npos;
+    }
+
+    const std::vector<std::string> &lazyRow(size_t row) const
+    {
+        std::lock_guard<std::mutex> lock(lazyMutex);
+        auto found = lazyRows.find(row);
+        if (found != lazyRows.end())
+        {
+            return found->second; // the nodes of the map do not move, the reference outlives the lock
+        }
+        std::vector<std::string> &cells = lazyRows[row];
+        std::string line;
+        lazyFile.clear();
+        if (lazyFile.seekg(static_cast<std::streamoff>(indexes[lazyIndex].getRowOffsets()[row])) && std::getline(lazyFile, line))
+        {
+            splitLine(line, cells);
+        }
+        return cells;
+    }
+
+    void resetLazyRows()
+    {
+        lazyIndex = std::string::npos;
+        lazyRows.clear();
+        if (lazyFile.is_open())
+        {
+            lazyFile.close();
+        }
+    }
+
+    void appendRow(std::vector<std::string> &&row)
+    {
+        if (encodedData)
+        {
+            encodedData->appendRow(row);
+        }
+        else
+        {
+            csvData.push_back(std::move(row));
+        }
+    }
+
+    // copies a row of the reader into a recycled row, reusing the capacity of its cells
+    void copyRow(const std::vector<std::string> &row)
+    {
+        if (encodedData)
+        {
+            encodedData->appendRow(row);
+            return;
+        }
+        std::vector<std::string> target = rowPool.acquire();
+        target.resize(row.size());
+        for (size_t i = 0; i < row.size(); ++i)
+        {
+            target[i].assign(row[i]);
+        }
+        csvData.push_back(std::move(target));
+    }
+
+    // frees the table, including the recycled rows
+    void releaseRows()
+    {
+        std::vector<std::vector<std::string>>().swap(csvData);
+        rowPool.clear();
+        columnarData.reset();
+        resetLazyRows();
+        if (encodedData)
+        {
+            encodedData->release();
+        }
+        if (rawData)
+        {
+            rawData->release();
+        }
+    }
+
+    // empties the table before a new read; the rows go back to the pool with their capacity
+    void recycleRows()
+    {
+        for (std::vector<std::string> &row : csvData)
+        {
+            rowPool.release(std::move(row));
+        }
+        csvData.clear();
+        columnarData.reset();
+        resetLazyRows();
+        if (encodedData)
+        {
+            encodedData->clear();
+        }
+        if (rawData)
+        {
+            rawData->clear();
+        }
+    }
+
+    // splits a line at the commas into row, overwriting the cells already there
+    static void splitLine(const std::string &line, std::vector<std::string> &row)
+    {
+        size_t count = 0;
+        size_t start = 0;
+        while (start < line.size())
+        {
+            size_t end = line.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = line.size();
+            }
+            if (count < row.size())
+            {
+                row[count].assign(line, start, end - start);
+            }
+            else
+            {
+                row.emplace_back(line, start, end - start);
+            }
+            count++;
+            start = end + 1;
+        }
+        row.resize(count);
+    }
+
+    // reads the rows of one CSV file and passes them one by one to addRow, until it returns false; the row
+    // is reused for the next line, so addRow either copies it or moves it away
+    template <typename RowSink>
+    static bool readCSVFile(const std::string &fileName, RowSink &&addRow)
+    {
+        TraceScope ioScope("io", "read ", fileName);
+        std::ifstream inputFile;
+        inputFile.rdbuf()->pubsetbuf(readBuffer.data(), readBuffer.size());
+        inputFile.open(fileName);
+
+        // checks if the file is open
+        if (!inputFile.is_open())
+        {
+            return false;
+        }
+        static thread_local std::string line;
+        static thread_local std::vector<std::string> row;
+        while (!CancellationToken::stopRequested() && std::getline(inputFile, line))
+        {
+            splitLine(line, row);
+            if (!addRow(row))
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    // glob match of a file name, '*' matches any sequence of characters and '?' any single character
+    static bool matchesPattern(const std::string &pattern, const std::string &name)
+    {
+        size_t p = 0, n = 0, starPattern = std::string::npos, starName = 0;
+        while (n < name.size())
+        {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+            {
+                ++p;
+                ++n;
+            }
+            else if (p < pattern.size() && pattern[p] == '*')
+            {
+                starPattern = p++;
+                starName = n;
+            }
+            else if (starPattern != std::string::npos)
+            {
+                p = starPattern + 1;
+                n = ++starName;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*')
+        {
+            ++p;
+        }
+        return p == pattern.size();
+    }
+
+    // a directory (all its .csv files) or a pattern with wildcards in the file name part designate several
+    // files; returns false for a plain file name
+    static bool expandInputFiles(const std::filesystem::path &path, std::vector<std::string> &files)
+    {
+        std::error_code error;
+        std::filesystem::path directory;
+        std::string namePattern;
+        if (std::filesystem::is_directory(path, error))
+        {
+            directory = path;
+            namePattern = "*.csv";
+        }
+        else if (path.filename().string().find_first_of("*?") != std::string::npos)
+        {
+            directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+            namePattern = path.filename().string();
+        }
+        else
+        {
+            return false;
+        }
+
+        for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+        {
+            if (it->is_regular_file(error) && matchesPattern(namePattern, it->path().filename().string()))
+            {
+                files.push_back(it->path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return true;
+    }
+
+    // reads all the files concurrently and merges their rows into csvData; the reading stops when the memory
+    // budget is exceeded, exceeded is then set to the account over its budget
+    void readCSVFiles(const std::vector<std::string> &files, MemoryAccount *&exceeded)
+    {
+        std::atomic<MemoryAccount *> exceededAccount{nullptr};
+        std::vector<uint64_t> sizes(files.size());
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            std::error_code error;
+            sizes[i] = std::filesystem::file_size(files[i], error);
+        }
+
+        std::vector<std::vector<std::vector<std::string>>> tables(files.size());
+        std::vector<size_t> completionOrder;
+        std::mutex completionMutex;
+        WorkStealingScheduler::run(sizes, [&](size_t i)
+                                   {
+            bool opened = readCSVFile(files[i], [&tables, &exceededAccount, i](std::vector<std::string> &row)
+                                      {
+                                          if (MemoryAccount *account = MemoryAccount::exceededBudget())
+                                          {
+                                              exceededAccount = account;
+                                              return false;
+                                          }
+                                          if (exceededAccount.load(std::memory_order_relaxed))
+                                          {
+                                              return false;
+                                          }
+                                          tables[i].push_back(std::move(row));
+                                          return true; });
+            std::lock_guard<std::mutex> lock(completionMutex);
+            if (!opened)
+            {
+                std::cerr << "Unable to open file: " << files[i] << std::endl;
+            }
+            completionOrder.push_back(i); });
+        exceeded = exceededAccount.load();
+        if (exceeded)
+        {
+            return;
+        }
+
+        if (deterministicOrder)
+        {
+            std::sort(completionOrder.begin(), completionOrder.end());
+        }
+        if (!encodedData)
+        {
+            size_t rowCount = csvData.size();
+            for (const auto &table : tables)
+            {
+                rowCount += table.size();
+            }
+            csvData.reserve(rowCount);
+        }
+        for (size_t i : completionOrder)
+        {
+            for (std::vector<std::string> &row : tables[i])
+            {
+                appendRow(std::move(row));
+            }
+            std::vector<std::vector<std::string>>().swap(tables[i]);
+        }
+    }
+
+public:
+    // constructor for csv file input step; file_name can also be a directory or a pattern like "data/*.csv"
+    CSVFileInputStep(const std::string &description, const std::string &file_name) : description(description), file_name(file_name), inputPath(file_name), deterministicOrder(true) {}
+
+    void execute() override
+    {
+        std::cout << "Description: " << description << "\nFile name: " << file_name << std::endl;
+        recycleRows();
+
+        std::vector<std::string> files;
+        MemoryAccount *exceeded = nullptr; // set when the rows do not fit in the memory budget
+        bool multipleFiles = expandInputFiles(inputPath, files);
+        bool columnarInput = !multipleFiles && ColumnarTable::isColumnarFile(file_name);
+
+        // the indexes of a CSV file are loaded before it is read: when all of them are valid and no consumer
+        // reads every row, the file is not read at all and a lookup reads only the rows it finds
+        std::vector<char> indexLoaded(indexes.size(), 0);
+        if (!multipleFiles && !columnarInput)
+        {
+            for (size_t i = 0; i < indexes.size(); ++i)
+            {
+                indexLoaded[i] = indexes[i].load(CSVColumnIndex::sidecarPath(file_name, indexes[i].getKind(), indexes[i].getColumn()), file_name);
+            }
+            if (!allRowsRequired && !encodedData && !indexes.empty() && std::find(indexLoaded.begin(), indexLoaded.end(), 0) == indexLoaded.end())
+            {
+                lazyFile.open(file_name);
+                if (lazyFile.is_open())
+                {
+                    lazyIndex = 0;
+                    std::cout << "Indexed file: " << getRowCount() << " rows, read only when a lookup finds them" << std::endl;
+                    return;
+                }
+            }
+        }
+
+        if (columnarInput)
+        {
+            // written by a columnar OUTPUT step: mapped as is, the cells are read in place
+            columnarData = std::make_unique<ColumnarTable>();
+            if (!columnarData->open(file_name))
+            {
+                std::cerr << "Invalid columnar file: " << file_name << std::endl;
+                columnarData.reset();
+                return;
+            }
+            std::cout << "Columnar file: " << columnarData->getRowCount() << " rows, " << columnarData->getColumnCount() << " columns, " << columnarData->getBlockCount() << " blocks" << std::endl;
+        }
+        else if (rawData)
+        {
+            // the lines are kept as read, only the declared columns are split, on their first access
+            for (const std::string &file : files)
+            {
+                if (MemoryAccount::exceededBudget())
+                {
+                    break;
+                }
+                if (!rawData->read(file))
+                {
+                    std::cerr << "Unable to open file: " << file << std::endl;
+                }
+            }
+            if (!multipleFiles && !rawData->read(file_name))
+            {
+                std::cerr << "Unable to open file: " << file_name << std::endl;
+                return;
+            }
+            exceeded = MemoryAccount::exceededBudget();
+        }
+        else if (multipleFiles)
+        {
+            readCSVFiles(files, exceeded);
+        }
+        else if (!readCSVFile(file_name, [this, &exceeded](const std::vector<std::string> &row)
+                              {
+                                  exceeded = MemoryAccount::exceededBudget();
+                                  if (exceeded)
+                                  {
+                                      return false;
+                                  }
+                                  copyRow(row);
+                                  return true; }))
+        {
+            std::cerr << "Unable to open file: " << file_name << std::endl;
+            return;
+        }
+        if (CancellationToken::stopped())
+        {
+            recycleRows(); // the rows read before the deadline are not kept as if they were the whole file
+            CancellationToken::check();
+        }
+        if (multipleFiles)
+        {
+            std::cout << "Read " << files.size() << " files" << std::endl;
+        }
+
+        // over the memory budget the rows are dropped and, unless the policy is to fail, read again and
+        // displayed without being kept
+        if (exceeded)
+        {
+            releaseRows();
+            if (exceeded->getPolicy() == MemoryBudgetPolicy::FailFast)
+            {
+                throw MemoryBudgetExceeded(exceeded->budgetMessage());
+            }
+            std::cout << "The " << exceeded->budgetMessage() << ", the rows are streamed instead of kept" << std::endl;
+            std::cout << "CSV content: " << std::endl;
+            auto displayCells = [](const std::vector<std::string> &row)
+            {
+                for (const std::string &cell : row)
+                {
+                    std::cout << cell << " | ";
+                }
+                std::cout << std::endl;
+                return true;
+            };
+            if (!multipleFiles)
+            {
+                files.push_back(file_name);
+            }
+            for (const std::string &file : files)
+            {
+                readCSVFile(file, displayCells);
+            }
+            CancellationToken::check();
+            return;
+        }
+
+        for (size_t i = 0; i < indexes.size(); ++i)
+        {
+            if (multipleFiles)
+            {
+                indexes[i].build(*this); // the indexes of a group of files are only kept in memory
+            }
+            else if (!indexLoaded[i])
+            {
+                indexes[i].buildAndSave(file_name, *this);
+            }
+        }
+
+        if (isDictionaryEncoded())
+        {
+            std::cout << "Dictionary encoded: " << encodedData->getRowCount() << " rows, " << encodedData->getPool().size() << " distinct strings";
+            if (encodedData->getPlainColumnCount() > 0)
+            {
+                std::cout << ", " << encodedData->getPlainColumnCount() << " columns kept as text (too many distinct values)";
+            }
+            std::cout << std::endl;
+        }
+
+        // display the CSV data
+        std::cout << "CSV content: " << std::endl;
+        for (size_t row = 0; row < getRowCount(); ++row)
+        {
+            CancellationToken::checkpoint();
+            displayRow(row);
+        }
+    }
+
+    // stores the cells as ids of an interned string pool instead of separate strings; meant for repetitive
+    // data, where equal values then share one string and compare, group and deduplicate as integers
+    void setDictionaryEncoding(bool enabled)
+    {
+        if (enabled && !encodedData)
+        {
+            encodedData = std::make_unique<DictionaryTable>();
+            for (const std::vector<std::string> &row : csvData)
+            {
+                encodedData->appendRow(row);
+            }
+            std::vector<std::vector<std::string>>().swap(csvData);
+            // the encoded table keeps all the columns, the raw lines are not needed any more
+            for (size_t row = 0; rawData && row < rawData->getRowCount(); ++row)
+            {
+                std::vector<std::string> cells;
+                rawData->forEachCell(row, [&cells](std::string_view cell)
+                                     { cells.emplace_back(cell); });
+                encodedData->appendRow(cells);
+            }
+            rawData.reset();
+        }
+        else if (!enabled && encodedData)
+        {
+            for (size_t row = 0; row < encodedData->getRowCount(); ++row)
+            {
+                std::vector<std::string> cells;
+                for (size_t column = 0; column < encodedData->getCellCount(row); ++column)
+                {
+                    cells.emplace_back(encodedData->getCell(row, column));
+                }
+                csvData.push_back(std::move(cells));
+            }
+            encodedData.reset();
+        }
+    }
+
+    bool isDictionaryEncoded() const
+    {
+        return getDictionaryTable() != nullptr;
+    }
+
+    // the encoded table, or nullptr when dictionary encoding is off or the input is a columnar file
+    const DictionaryTable *getDictionaryTable() const
+    {
+        return columnarData ? nullptr : encodedData.get();
+    }
+
+    // with several input files, true merges the rows in file path order, false in the order the files finish
+    void setDeterministicOrder(bool deterministic)
+    {
+        deterministicOrder = deterministic;
+    }
+
+    std::string getType() const override
+    {
+        return "CSV FILE INPUT";
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(description).add(file_name);
+    }
+
+    // one fingerprint per row, over all its cells
+    void fingerprintRecords(const std::function<void(uint64_t)> &visit) const override
+    {
+        if (readsLazily())
+        {
+            // streamed rather than read row by row at the offsets of the index
+            readCSVFile(file_name, [&visit](const std::vector<std::string> &row)
+                        {
+                Fingerprint fingerprint;
+                for (const std::string &cell : row)
+                {
+                    fingerprint.add(cell);
+                }
+                visit(fingerprint.digest());
+                return true; });
+            return;
+        }
+        for (size_t row = 0; row < getRowCount(); ++row)
+        {
+            Fingerprint fingerprint;
+            forEachCell(row, [&fingerprint](std::string_view cell)
+                        { fingerprint.add(cell); });
+            visit(fingerprint.digest());
+        }
+    }
+
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays a description and the name of the file" << std::endl;
+    }
+
+    // projection: the consumers declare the columns they read. The step then keeps the lines of the file
+    // as read and splits only these columns, on their first access, so reading a wide file costs little
+    // more than reading its bytes. Ignored for dictionary encoded tables, which keep all the columns
+    void requireColumns(const std::vector<size_t> &columns)
+    {
+        if (encodedData)
+        {
+            return;
+        }
+        if (!rawData)
+        {
+            if (!csvData.empty())
+            {
+                return; // already read row by row, switched at the next read
+            }
+            rawData = std::make_unique<RawCSVTable>();
+        }
+        for (size_t column : columns)
+        {
+            rawData->addColumn(column);
+        }
+    }
+
+    // a consumer that reads every row (display, aggregate, export): the file is then always read, even when
+    // its indexes could serve the lookups
+    void requireAllRows()
+    {
+        allRowsRequired = true;
+    }
+
+    // returneaza randurile citite din fisier (empty when the table is dictionary encoded, projected or read lazily, use getCell instead)
+    const std::vector<std::vector<std::string>> &getCSVData() const
+    {
+        return csvData;
+    }
+
+    size_t getRowCount() const
+    {
+        if (columnarData)
+        {
+            return columnarData->getRowCount();
+        }
+        if (readsLazily())
+        {
+            return indexes[lazyIndex].getRowOffsets().size();
+        }
+        if (rawData)
+        {
+            return rawData->getRowCount();
+        }
+        return encodedData ? encodedData->getRowCount() : csvData.size();
+    }
+
+    size_t getCellCount(size_t row) const
+    {
+        if (columnarData)
+        {
+            return columnarData->getCellCount(row);
+        }
+        if (readsLazily())
+        {
+            return lazyRow(row).size();
+        }
+        if (rawData)
+        {
+            return rawData->getCellCount(row);
+        }
+        return encodedData ? encodedData->getCellCount(row) : csvData[row].size();
+    }
+
+    bool hasCell(size_t row, size_t column) const
+    {
+        if (columnarData)
+        {
+            return columnarData->hasCell(row, column);
+        }
+        return rawData && !readsLazily() ? rawData->hasCell(row, column) : column < getCellCount(row);
+    }
+
+    // the cell, or an empty string when the row has fewer columns
+    std::string_view getCell(size_t row, size_t column) const
+    {
+        if (columnarData)
+        {
+            return columnarData->getCell(row, column);
+        }
+        if (readsLazily())
+        {
+            const std::vector<std::string> &cells = lazyRow(row);
+            return column < cells.size() ? std::string_view(cells[column]) : std::string_view();
+        }
+        if (rawData)
+        {
+            return rawData->getCell(row, column);
+        }
+        if (encodedData)
+        {
+            return encodedData->getCell(row, column);
+        }
+        return column < csvData[row].size() ? std::string_view(csvData[row][column]) : std::string_view();
+    }
+
+    // calls visit(cell) for all the cells of a row
+    template <typename Visit>
+    void forEachCell(size_t row, Visit &&visit) const
+    {
+        if (rawData && !columnarData && !readsLazily())
+        {
+            rawData->forEachCell(row, visit);
+            return;
+        }
+        for (size_t column = 0; column < getCellCount(row); ++column)
+        {
+            visit(getCell(row, column));
+        }
+    }
+
+    void displayRow(size_t row) const
+    {
+        forEachCell(row, [](std::string_view cell)
+                    { std::cout << cell << " | "; });
+        std::cout << std::endl;
+    }
+
+    // the cell as a number; false when the row has no such cell or it is not numeric. The numbers of a
+    // columnar file are read as stored
+    bool getNumber(size_t row, size_t column, double &number) const
+    {
+        if (columnarData)
+        {
+            return columnarData->getNumber(row, column, number);
+        }
+        return hasCell(row, column) && parseFiniteNumber(getCell(row, column), number);
+    }
+
+    // the mapped columnar file, or nullptr when the input is a CSV file
+    const ColumnarTable *getColumnarTable() const
+    {
+        return columnarData.get();
+    }
+
+    // requests an index on a column, it is loaded from its sidecar file or rebuilt when the file is read
+    void addIndex(IndexKind kind, size_t column)
+    {
+        requireColumns({column});
+        for (const CSVColumnIndex &index : indexes)
+        {
+            if (index.getKind() == kind && index.getColumn() == column)
+            {
+                return;
+            }
+        }
+        indexes.emplace_back(kind, column);
+    }
+
+    // rows whose column lies in [low, high] (low == high for equality), using an index when one fits
+    std::vector<size_t> findRows(size_t column, const std::string &low, const std::string &high) const
+    {
+        for (const CSVColumnIndex &index : indexes)
+        {
+            if (index.getColumn() == column && (low == high || index.getKind() == IndexKind::Sorted))
+            {
+                return low == high ? index.lookup(low) : index.lookupRange(low, high);
+            }
+        }
+
+        // no index on this column: a columnar file skips the blocks out of the range, a CSV file scans all rows
+        if (columnarData)
+        {
+            return columnarData->findRows(column, low, high);
+        }
+        std::vector<size_t> rows;
+        double lowNumber, highNumber, number;
+        bool numericRange = parseFiniteNumber(low, lowNumber) && parseFiniteNumber(high, highNumber);
+        for (size_t row = 0; row < getRowCount(); ++row)
+        {
+            if (!hasCell(row, column))
+            {
+                continue;
+            }
+            std::string_view cell = getCell(row, column);
+            bool inRange = numericRange && parseFiniteNumber(cell, number) ? (number >= lowNumber && number <= highNumber) : (cell >= low && cell <= high);
+            if (inRange)
+            {
+                rows.push_back(row);
+            }
+        }
+        return rows;
+    }
+};
+
+class DisplayStep : public Step
+{
+private:
+    // pointer to the previous step to be able to take the informations from them
+    Step *previousStep;
+    // the previous step resolved once by type, only the pointer matching its type is set
+    TextInputStep *textInputStep;
+    CSVInputStep *csvInputStep;
+    CSVFileInputStep *csvFileInputStep;
+    // optional key: only the rows of a CSV FILE INPUT step whose column equals it are displayed
+    bool hasKey;
+    size_t keyColumn;
+    std::string key;
+    // part of a file that is displayed (length 0 = up to the end) and size of a page (0 = no paging)
+    uint64_t rangeOffset;
+    uint64_t rangeLength;
+    uint64_t pageSize;
+
+    static const size_t COPY_BUFFER_SIZE = 64 * 1024;
+    static constexpr size_t COPY_CHUNK_SIZE = 64 * 1024 * 1024; // bytes copied by the kernel between two deadline checks
+    // stream buffer of the real standard output; std::cout is rebound while the flow server runs a request
+    static inline std::streambuf *const consoleBuffer = std::cout.rdbuf();
+
+    // copies [offset, offset + length) of the file to the standard output in a fixed buffer
+    static bool copyBuffered(const std::string &fileName, uint64_t offset, uint64_t length)
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(offset)))
+        {
+            return false;
+        }
+        char buffer[COPY_BUFFER_SIZE];
+        while (length > 0 && file)
+        {
+            CancellationToken::checkpoint();
+            file.read(buffer, static_cast<std::streamsize>(std::min<uint64_t>(length, sizeof(buffer))));
+            std::streamsize count = file.gcount();
+            if (count <= 0)
+            {
+                break;
+            }
+            std::cout.write(buffer, count);
+            length -= static_cast<uint64_t>(count);
+        }
+        return static_cast<bool>(std::cout);
+    }
+
+    // copies [offset, offset + length) of the file to the standard output. On Linux the bytes move from the
+    // page cache to stdout inside the kernel (sendfile, or splice when stdout is a pipe); when stdout
+    // accepts neither, the copy continues through a buffer
+    static bool copyToStdout(const std::string &fileName, uint64_t offset, uint64_t length)
+    {
+        std::cout.flush();
+#ifdef __linux__
+        if (std::cout.rdbuf() != consoleBuffer)
+        {
+            return copyBuffered(fileName, offset, length);
+        }
+        std::fflush(stdout);
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat outputStat;
+        bool outputIsPipe = fstat(STDOUT_FILENO, &outputStat) == 0 && S_ISFIFO(outputStat.st_mode);
+        off_t position = static_cast<off_t>(offset);
+        bool useSplice = false;
+        while (length > 0)
+        {
+            if (CancellationToken::stopped())
+            {
+                close(fd);
+                CancellationToken::check();
+            }
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(length, COPY_CHUNK_SIZE));
+            ssize_t copied = useSplice ? splice(fd, &position, STDOUT_FILENO, nullptr, chunk, SPLICE_F_MORE) : sendfile(STDOUT_FILENO, fd, &position, chunk);
+            if (copied > 0)
+            {
+                length -= static_cast<uint64_t>(copied);
+                continue;
+            }
+            if (copied == 0)
+            {
+                break;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (!useSplice && outputIsPipe && (errno == EINVAL || errno == ENOSYS))
+            {
+                useSplice = true;
+                continue;
+            }
+            // stdout is not a target the kernel can copy into, copy the rest through the buffer
+            close(fd);
+            return copyBuffered(fileName, static_cast<uint64_t>(position), length);
+        }
+        close(fd);
+        return true;
+#else
+        return copyBuffered(fileName, offset, length);
+#endif
+    }
+
+public:
+    DisplayStep(Step *prevStep) : previousStep(prevStep), textInputStep(dynamic_cast<TextInputStep *>(prevStep)), csvInputStep(dynamic_cast<CSVInputStep *>(prevStep)), csvFileInputStep(dynamic_cast<CSVFileInputStep *>(prevStep)), hasKey(false), keyColumn(0), rangeOffset(0), rangeLength(0), pageSize(0)
+    {
+        if (csvFileInputStep)
+        {
+            csvFileInputStep->requireAllRows();
+        }
+    }
+
+    // only the rows whose column equals the key are displayed, so an index on the column can serve them
+    DisplayStep(Step *prevStep, size_t keyColumn, const std::string &key) : previousStep(prevStep), textInputStep(dynamic_cast<TextInputStep *>(prevStep)), csvInputStep(dynamic_cast<CSVInputStep *>(prevStep)), csvFileInputStep(dynamic_cast<CSVFileInputStep *>(prevStep)), hasKey(true), keyColumn(keyColumn), key(key), rangeOffset(0), rangeLength(0), pageSize(0)
+    {
+        if (csvFileInputStep)
+        {
+            csvFileInputStep->requireColumns({keyColumn});
+        }
+    }
+
+    // displays only length bytes of the file starting at offset (length 0 = up to the end of the file)
+    void setByteRange(uint64_t offset, uint64_t length)
+    {
+        rangeOffset = offset;
+        rangeLength = length;
+    }
+
+    // displays the file one page of pageBytes at a time, waiting for the user between pages (0 = no paging)
+    void setPageSize(uint64_t pageBytes)
+    {
+        pageSize = pageBytes;
+    }
+
+    void execute() override
+    {
+        std::cout << "Displaying information from the previous step:... " << std::endl;
+        // afiseaza informatiile corespunzatoare tipului pasului anterior
+        if (textInputStep)
+        {
+            std::cout << "Text Input Content: " << textInputStep->getTextInput() << std::endl;
+        }
+        else if (csvInputStep)
+        {
+            displayFileContent(csvInputStep->getFileName());
+        }
+        else if (csvFileInputStep)
+        {
+            displayRows(*csvFileInputStep);
+        }
+        else
+        {
+            std::cout << "Cannot display information. Previous step type not supported" << std::endl;
+        }
+    }
+
+    std::string getType() const override
+    {
+        return "DISPLAY";
+    }
+
+    const Step *getSource() const override
+    {
+        return previousStep;
+    }
+
+    // true when the step displays the whole file of a CSV INPUT step without paging, which is then
+    // the CSV data that step holds in memory
+    bool canDisplayFromMemory() const
+    {
+        return csvInputStep && pageSize == 0;
+    }
+
+    // same output as execute for a CSV INPUT step whose data was just saved, without reading the file back
+    void displayFromMemory() const
+    {
+        std::cout << "Displaying information from the previous step:... " << std::endl;
+        const std::string &content = csvInputStep->getCSVInput();
+        uint64_t offset = std::min<uint64_t>(rangeOffset, content.size());
+        uint64_t end = rangeLength > 0 ? std::min<uint64_t>(content.size(), offset + rangeLength) : content.size();
+        std::cout << "File Content:" << std::endl;
+        std::cout.write(content.data() + offset, static_cast<std::streamsize>(end - offset));
+        std::cout << std::endl;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(previousStep ? previousStep->fingerprint() : 0);
+        fingerprint.add(hasKey).add(keyColumn).add(key);
+        fingerprint.add(rangeOffset).add(rangeLength).add(pageSize);
+    }
+
+    // function used to see if the user wants to skip to the next step
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    // function to display the informations from the file
+    void displayFileContent(const std::string &fileName) const
+    {
+        TraceScope ioScope("io", "read ", fileName);
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(fileName, error);
+        if (error)
+        {
+            std::cout << "Error: Unable to open file '" << fileName << "'." << std::endl;
+            return;
+        }
+
+        // the file is streamed to the output in pages instead of being loaded in memory
+        uint64_t offset = std::min(rangeOffset, fileSize);
+        uint64_t end = rangeLength > 0 ? std::min(fileSize, offset + rangeLength) : fileSize;
+        std::cout << "File Content:" << std::endl;
+        while (offset < end)
+        {
+            uint64_t length = pageSize > 0 ? std::min(pageSize, end - offset) : end - offset;
+            if (!copyToStdout(fileName, offset, length))
+            {
+                std::cout << std::endl
+                          << "Error: Unable to read file '" << fileName << "'." << std::endl;
+                return;
+            }
+            offset += length;
+
+            if (offset < end)
+            {
+                std::cout << std::endl
+                          << "-- " << offset << "/" << end << " bytes, press enter for more or 'q' to stop --";
+                TraceScope waitScope("wait", "next page");
+                std::string answer;
+                std::getline(std::cin, answer);
+                if (!answer.empty() && (answer[0] == 'q' || answer[0] == 'Q'))
+                {
+                    break;
+                }
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // displays the loaded rows, or only the rows matching the key (found through the column index if there is one)
+    void displayRows(const CSVFileInputStep &csvFileInputStep) const
+    {
+        if (!hasKey)
+        {
+            for (size_t row = 0; row < csvFileInputStep.getRowCount(); ++row)
+            {
+                CancellationToken::checkpoint();
+                csvFileInputStep.displayRow(row);
+            }
+            return;
+        }
+        for (size_t row : csvFileInputStep.findRows(keyColumn, key, key))
+        {
+            CancellationToken::checkpoint();
+            csvFileInputStep.displayRow(row);
+        }
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays informations about the other steps" << std::endl;
+    }
+};
+
+class LookupStep : public Step
+{
+private:
+    // pointer to the csv file step whose rows are searched
+    CSVFileInputStep *sourceStep;
+    size_t column;
+    std::string low;  // key for equality lookups
+    std::string high; // upper bound for range lookups, equal to low otherwise
+
+public:
+    LookupStep(CSVFileInputStep *source, size_t column, const std::string &low, const std::string &high) : sourceStep(source), column(column), low(low), high(high)
+    {
+        sourceStep->requireColumns({column});
+    }
+
+    void execute() override
+    {
+        std::vector<size_t> rows = sourceStep->findRows(column, low, high);
+        std::cout << "Found " << rows.size() << " matching rows:" << std::endl;
+        for (size_t row : rows)
+        {
+            CancellationToken::checkpoint();
+            std::cout << "Row " << row << ": ";
+            sourceStep->displayRow(row);
+        }
+    }
+
+    std::string getType() const override
+    {
+        return "LOOKUP";
+    }
+
+    const Step *getSource() const override
+    {
+        return sourceStep;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(sourceStep->fingerprint()).add(column).add(low).add(high);
+    }
+
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays the rows of a CSV file whose column matches a key or a range" << std::endl;
+    }
+};
+
+// position of the first occurrence of pattern in text at or after from, npos when there is none.
+// With SSE2 the first and last byte of the pattern are compared against 16 candidate positions at
+// once and only the positions where both match are verified with memcmp
+inline size_t findSubstring(std::string_view text, std::string_view pattern, size_t from)
+{
+    size_t length = pattern.size();
+    if (length == 0)
+    {
+        return from <= text.size() ? from : std::string_view::npos;
+    }
+    if (text.size() < length || from > text.size() - length)
+    {
+        return std::string_view::npos;
+    }
+    const char *data = text.data();
+    size_t last = text.size() - length; // last position where the pattern fits
+    size_t position = from;
+#if defined(__SSE2__)
+    const __m128i firstByte = _mm_set1_epi8(pattern[0]);
+    const __m128i lastByte = _mm_set1_epi8(pattern[length - 1]);
+    for (; position + 16 <= last + 1; position += 16)
+    {
+        __m128i firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + position));
+        __m128i lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + position + length - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstByte, firstBlock), _mm_cmpeq_epi8(lastByte, lastBlock)));
+        while (mask != 0)
+        {
+            size_t candidate = position + __builtin_ctz(mask);
+            if (length <= 2 || memcmp(data + candidate + 1, pattern.data() + 1, length - 2) == 0)
+            {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    // tail of the text (or all of it without SSE2): memchr to the first byte, then compare
+    while (position <= last)
+    {
+        const char *hit = static_cast<const char *>(memchr(data + position, pattern[0], last - position + 1));
+        if (hit == nullptr)
+        {
+            return std::string_view::npos;
+        }
+        position = hit - data;
+        if (memcmp(hit, pattern.data(), length) == 0)
+        {
+            return position;
+        }
+        ++position;
+    }
+    return std::string_view::npos;
+}
+
+// Aho-Corasick automaton over several patterns, compiled to a dense DFA (one 256 entry row per
+// state) so the text is scanned once with a single table lookup per byte whatever the pattern count
+class AhoCorasick
+{
+private:
+    std::vector<uint32_t> transitions; // state * 256 + byte -> next state
+    std::vector<uint32_t> matchLength; // length of the longest pattern ending in the state, 0 if none
+    std::vector<uint8_t> accepting;
+    size_t longestPattern = 0;
+
+public:
+    explicit AhoCorasick(const std::vector<std::string> &patterns)
+    {
+        // trie of the patterns, 0 standing for "no edge" since the root is never a child
+        transitions.assign(256, 0);
+        matchLength.assign(1, 0);
+        accepting.assign(1, 0);
+        for (const std::string &pattern : patterns)
+        {
+            uint32_t state = 0;
+            for (unsigned char byte : pattern)
+            {
+                uint32_t &next = transitions[state * 256 + byte];
+                if (next == 0)
+                {
+                    next = static_cast<uint32_t>(accepting.size());
+                    transitions.resize(transitions.size() + 256, 0);
+                    matchLength.push_back(0);
+                    accepting.push_back(0);
+                }
+                state = transitions[state * 256 + byte]; // the resize may have moved next
+            }
+            accepting[state] = 1;
+            matchLength[state] = std::max<uint32_t>(matchLength[state], static_cast<uint32_t>(pattern.size()));
+            longestPattern = std::max(longestPattern, pattern.size());
+        }
+
+        // breadth first over the trie: missing edges are replaced by the edge of the failure state
+        std::vector<uint32_t> failure(accepting.size(), 0);
+        std::deque<uint32_t> queue;
+        for (size_t byte = 0; byte < 256; ++byte)
+        {
+            if (transitions[byte] != 0)
+            {
+                queue.push_back(transitions[byte]);
+            }
+        }
+        while (!queue.empty())
+        {
+            uint32_t state = queue.front();
+            queue.pop_front();
+            if (accepting[failure[state]])
+            {
+                accepting[state] = 1;
+                matchLength[state] = std::max(matchLength[state], matchLength[failure[state]]);
+            }
+            for (size_t byte = 0; byte < 256; ++byte)
+            {
+                uint32_t &next = transitions[state * 256 + byte];
+                uint32_t fallback = transitions[failure[state] * 256 + byte];
+                if (next == 0)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+
+    // leftmost occurrence of any pattern at or after from, scanned from the root state. Returns its
+    // start or npos, the same offset a findSubstring per pattern would give at its minimum
+    size_t find(std::string_view text, size_t from) const
+    {
+        if (accepting[0])
+        {
+            return from; // an empty pattern matches everywhere
+        }
+        const uint32_t *table = transitions.data();
+        const uint8_t *isFinal = accepting.data();
+        uint32_t state = 0;
+        size_t best = std::string_view::npos;
+        for (size_t position = from; position < text.size(); ++position)
+        {
+            // a match ending here starts at position + 1 - longestPattern at the earliest
+            if (best != std::string_view::npos && position + 1 >= best + longestPattern)
+            {
+                break;
+            }
+            state = table[state * 256 + static_cast<unsigned char>(text[position])];
+            if (isFinal[state])
+            {
+                // the longest output of the state is the one starting furthest left
+                best = std::min(best, position + 1 - matchLength[state]);
+            }
+        }
+        return best;
+    }
+};
+
+// line of a text file containing at least one of the searched patterns
+struct TextMatch
+{
+    size_t lineNumber;  // 1-based
+    size_t lineOffset;  // byte offset of the line in the file
+    size_t matchOffset; // byte offset of the first occurrence in the line
+    size_t textStart;   // the line is matchedText[textStart, textStart + textLength)
+    size_t textLength;
+};
+
+class TextSearchStep : public Step
+{
+private:
+    // pointer to the text file step whose content is searched
+    TextFileInputStep *sourceStep;
+    std::vector<std::string> patterns;
+    std::unique_ptr<AhoCorasick> automaton; // used when there is more than one pattern
+
+    // results of the last run, kept with their capacity between runs
+    std::vector<TextMatch> matches;
+    std::string matchedText;
+    std::string chunk; // read buffer when the file is streamed
+
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    size_t findPattern(std::string_view text, size_t from) const
+    {
+        return automaton ? automaton->find(text, from) : findSubstring(text, patterns[0], from);
+    }
+
+    // searches a block made of whole lines (the last one may lack its newline at the end of the file).
+    // After a match the rest of its line is skipped, so each line is reported once; newlines are only
+    // counted up to the matches and once at the end of the block
+    void searchBlock(std::string_view block, size_t blockOffset, size_t &lineCount)
+    {
+        const char *data = block.data();
+        size_t position = 0; // always the start of a line
+        size_t counted = 0;  // newlines of block[0, counted) are included in lineCount
+        while (position < block.size())
+        {
+            CancellationToken::checkpoint();
+            size_t match = findPattern(block, position);
+            if (match == std::string_view::npos)
+            {
+                break;
+            }
+            size_t lineStart = match;
+            while (lineStart > position && data[lineStart - 1] != '\n')
+            {
+                --lineStart;
+            }
+            lineCount += std::count(data + counted, data + lineStart, '\n');
+            counted = lineStart;
+            const char *newline = static_cast<const char *>(memchr(data + match, '\n', block.size() - match));
+            size_t lineEnd = newline ? newline - data : block.size();
+
+            matches.push_back({lineCount + 1, blockOffset + lineStart, blockOffset + match, matchedText.size(), lineEnd - lineStart});
+            matchedText.append(data + lineStart, lineEnd - lineStart);
+            position = lineEnd + 1;
+        }
+        lineCount += std::count(data + counted, data + block.size(), '\n');
+    }
+
+    // reads the file in chunks, an incomplete last line being carried over to the next chunk
+    bool searchFile(const std::string &fileName)
+    {
+        TraceScope ioScope("io", "read ", fileName);
+        std::ifstream inputFile(fileName, std::ios::binary);
+        if (!inputFile.is_open())
+        {
+            return false;
+        }
+        chunk.resize(CHUNK_SIZE);
+        size_t carried = 0;
+        size_t chunkOffset = 0; // file offset of chunk[0]
+        size_t lineCount = 0;
+        while (true)
+        {
+            CancellationToken::check();
+            if (carried == chunk.size())
+            {
+                chunk.resize(chunk.size() * 2); // a line longer than the chunk
+            }
+            inputFile.read(&chunk[carried], chunk.size() - carried);
+            size_t size = carried + static_cast<size_t>(inputFile.gcount());
+            if (size == carried)
+            {
+                searchBlock(std::string_view(chunk.data(), size), chunkOffset, lineCount);
+                return true;
+            }
+            size_t complete = size;
+            while (complete > 0 && chunk[complete - 1] != '\n')
+            {
+                --complete;
+            }
+            if (complete == 0)
+            {
+                carried = size;
+                continue;
+            }
+            searchBlock(std::string_view(chunk.data(), complete), chunkOffset, lineCount);
+            carried = size - complete;
+            memmove(&chunk[0], chunk.data() + complete, carried);
+            chunkOffset += complete;
+        }
+    }
+
+public:
+    // patterns containing a newline can never match inside a line and are ignored
+    TextSearchStep(TextFileInputStep *source, const std::vector<std::string> &searched) : sourceStep(source)
+    {
+        for (const std::string &pattern : searched)
+        {
+            if (pattern.find('\n') == std::string::npos)
+            {
+                patterns.push_back(pattern);
+            }
+            else
+            {
+                std::cerr << "Ignoring a search pattern that spans several lines" << std::endl;
+            }
+        }
+        if (patterns.size() > 1)
+        {
+            automaton = std::make_unique<AhoCorasick>(patterns);
+        }
+    }
+
+    void execute() override
+    {
+        matches.clear();
+        matchedText.clear();
+        if (patterns.empty())
+        {
+            std::cout << "No search patterns" << std::endl;
+            return;
+        }
+        if (sourceStep->isContentLoaded())
+        {
+            size_t lineCount = 0;
+            searchBlock(sourceStep->getFileContent(), 0, lineCount);
+        }
+        else if (!searchFile(sourceStep->getFileName()))
+        {
+            std::cerr << "Unable to open the file: " << sourceStep->getFileName() << std::endl;
+            return;
+        }
+
+        // line:offset:text, as printed by grep -n -b
+        std::cout << "Found " << matches.size() << " matching lines:" << std::endl;
+        for (const TextMatch &match : matches)
+        {
+            std::cout << match.lineNumber << ':' << match.lineOffset << ':' << getLine(match) << '\n';
+        }
+        std::cout << std::flush;
+    }
+
+    const std::vector<TextMatch> &getMatches() const
+    {
+        return matches;
+    }
+
+    std::string_view getLine(const TextMatch &match) const
+    {
+        return std::string_view(matchedText).substr(match.textStart, match.textLength);
+    }
+
+    std::string getType() const override
+    {
+        return "TEXT SEARCH";
+    }
+
+    const Step *getSource() const override
+    {
+        return sourceStep;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(sourceStep->fingerprint()).add(static_cast<uint64_t>(patterns.size()));
+        for (const std::string &pattern : patterns)
+        {
+            fingerprint.add(pattern);
+        }
+    }
+
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step displays the lines of a text file that contain one of the searched patterns" << std::endl;
+    }
+};
+
+// comparison used by the row filter of an aggregate step
+enum class FilterOperator
+{
+    None,
+    Equal,
+    NotEqual,
+    Less,
+    LessOrEqual,
+    Greater,
+    GreaterOrEqual
+};
+
+// predicate "column operator value" applied to CSV rows. Values are compared as numbers when
+// both sides are numeric and as text otherwise
+struct RowFilter
+{
+    FilterOperator op = FilterOperator::None;
+    size_t column = 0;
+    std::string value;
+
+    // set by prepare: on an interned column of a dictionary encoded source, (in)equality with a text value is an id comparison
+    bool compareIds = false;
+    bool valueInterned = false;
+    uint32_t valueId = 0;
+
+    void prepare(const CSVFileInputStep &source)
+    {
+        double number;
+        const DictionaryTable *table = source.getDictionaryTable();
+        compareIds = table != nullptr && table->isColumnEncoded(column) && (op == FilterOperator::Equal || op == FilterOperator::NotEqual) && !parseFiniteNumber(value, number);
+        valueInterned = compareIds && table->getPool().find(value, valueId);
+    }
+
+    bool matches(const CSVFileInputStep &source, size_t row) const
+    {
+        if (op == FilterOperator::None)
+        {
+            return true;
+        }
+        if (!source.hasCell(row, column))
+        {
+            return false;
+        }
+        if (compareIds)
+        {
+            // a value missing from the pool is different from every cell
+            bool equal = valueInterned && source.getDictionaryTable()->getCellId(row, column) == valueId;
+            return equal == (op == FilterOperator::Equal);
+        }
+
+        int comparison;
+        double left, right;
+        if (parseFiniteNumber(value, right) && source.getNumber(row, column, left))
+        {
+            comparison = left < right ? -1 : (left > right ? 1 : 0);
+        }
+        else
+        {
+            comparison = source.getCell(row, column).compare(value);
+        }
+
+        switch (op)
+        {
+        case FilterOperator::Equal:
+            return comparison == 0;
+        case FilterOperator::NotEqual:
+            return comparison != 0;
+        case FilterOperator::Less:
+            return comparison < 0;
+        case FilterOperator::LessOrEqual:
+            return comparison <= 0;
+        case FilterOperator::Greater:
+            return comparison > 0;
+        case FilterOperator::GreaterOrEqual:
+            return comparison >= 0;
+        default:
+            return true;
+        }
+    }
+};
+
+// count/sum/min/max of one group; sum, min and max only use the numeric values
+struct AggregateValues
+{
+    size_t count = 0;
+    size_t numericCount = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    // numeric is false for a cell that is missing or not a number
+    void add(bool numeric, double number)
+    {
+        count++;
+        if (numeric)
+        {
+            numericCount++;
+            sum += number;
+            min = std::min(min, number);
+            max = std::max(max, number);
+        }
+    }
+
+    void merge(const AggregateValues &other)
+    {
+        count += other.count;
+        numericCount += other.numericCount;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    double average() const
+    {
+        return numericCount > 0 ? sum / numericCount : 0.0;
+    }
+};
+
+// open addressing (linear probing) hash table from the group-by values of a row to its aggregates.
+// Cell is std::string for plain tables or uint32_t for the string ids of dictionary encoded tables
+template <typename Cell>
+class GroupHashTable
+{
+private:
+    struct Slot
+    {
+        bool used = false;
+        uint64_t hash = 0;
+        std::vector<Cell> key;
+        AggregateValues values;
+    };
+
+    std::vector<Slot> slots; // size is always a power of two
+    size_t groupCount;
+
+    void grow()
+    {
+        std::vector<Slot> oldSlots(slots.size() * 2);
+        oldSlots.swap(slots);
+        for (Slot &slot : oldSlots)
+        {
+            if (slot.used)
+            {
+                size_t index = slot.hash & (slots.size() - 1);
+                while (slots[index].used)
+                {
+                    index = (index + 1) & (slots.size() - 1);
+                }
+                slots[index] = std::move(slot);
+            }
+        }
+    }
+
+    static auto cellAt(const CSVFileInputStep &source, size_t row, size_t column)
+    {
+        if constexpr (std::is_same_v<Cell, uint32_t>)
+        {
+            return source.getDictionaryTable()->getCellId(row, column);
+        }
+        else
+        {
+            return source.getCell(row, column);
+        }
+    }
+
+    // cell as read from the source: an id, or a view into the source row
+    using CellView = std::conditional_t<std::is_same_v<Cell, uint32_t>, uint32_t, std::string_view>;
+
+    static uint64_t hashCell(uint64_t hash, CellView cell)
+    {
+        uint64_t cellHash;
+        if constexpr (std::is_same_v<Cell, uint32_t>)
+        {
+            cellHash = cell * 0x9e3779b97f4a7c15ULL;
+        }
+        else
+        {
+            cellHash = std::hash<std::string_view>()(cell);
+        }
+        return hash ^ (cellHash + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+    }
+
+    static bool sameKey(const std::vector<Cell> &key, const CSVFileInputStep &source, size_t row, const std::vector<size_t> &columns)
+    {
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (key[i] != cellAt(source, row, columns[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Slot &findOrInsert(uint64_t hash, const std::vector<Cell> &key)
+    {
+        if ((groupCount + 1) * 10 > slots.size() * 7) // keep the load factor under 0.7
+        {
+            grow();
+        }
+        size_t index = hash & (slots.size() - 1);
+        while (slots[index].used && (slots[index].hash != hash || slots[index].key != key))
+        {
+            index = (index + 1) & (slots.size() - 1);
+        }
+        if (!slots[index].used)
+        {
+            slots[index].used = true;
+            slots[index].hash = hash;
+            slots[index].key = key;
+            groupCount++;
+        }
+        return slots[index];
+    }
+
+public:
+    GroupHashTable() : slots(64), groupCount(0) {}
+
+    static uint64_t hashKey(const CSVFileInputStep &source, size_t row, const std::vector<size_t> &columns)
+    {
+        uint64_t hash = 1469598103934665603ULL;
+        for (size_t column : columns)
+        {
+            hash = hashCell(hash, cellAt(source, row, column));
+        }
+        return hash;
+    }
+
+    // adds one row to its group, the key vector is only built for new groups
+    void add(const CSVFileInputStep &source, size_t row, const std::vector<size_t> &columns, size_t valueColumn)
+    {
+        uint64_t hash = hashKey(source, row, columns);
+        if ((groupCount + 1) * 10 > slots.size() * 7)
+        {
+            grow();
+        }
+        size_t index = hash & (slots.size() - 1);
+        while (slots[index].used && (slots[index].hash != hash || !sameKey(slots[index].key, source, row, columns)))
+        {
+            index = (index + 1) & (slots.size() - 1);
+        }
+        Slot &slot = slots[index];
+        if (!slot.used)
+        {
+            slot.used = true;
+            slot.hash = hash;
+            slot.key.reserve(columns.size());
+            for (size_t column : columns)
+            {
+                slot.key.emplace_back(cellAt(source, row, column));
+            }
+            groupCount++;
+        }
+        double number = 0.0;
+        bool numeric = source.getNumber(row, valueColumn, number);
+        slot.values.add(numeric, number);
+    }
+
+    // merges the partial aggregates computed by another thread
+    void merge(const GroupHashTable &other)
+    {
+        for (const Slot &slot : other.slots)
+        {
+            if (slot.used)
+            {
+                findOrInsert(slot.hash, slot.key).values.merge(slot.values);
+            }
+        }
+    }
+
+    // groups sorted by key; string ids are decoded with the pool of the encoded table
+    std::vector<std::pair<std::vector<std::string>, AggregateValues>> sortedGroups(const DictionaryTable *table) const
+    {
+        std::vector<std::pair<std::vector<std::string>, AggregateValues>> groups;
+        groups.reserve(groupCount);
+        for (const Slot &slot : slots)
+        {
+            if (slot.used)
+            {
+                std::vector<std::string> key;
+                key.reserve(slot.key.size());
+                for (const Cell &cell : slot.key)
+                {
+                    if constexpr (std::is_same_v<Cell, uint32_t>)
+                    {
+                        key.emplace_back(table->getString(cell));
+                    }
+                    else
+                    {
+                        key.push_back(cell);
+                    }
+                }
+                groups.emplace_back(std::move(key), slot.values);
+            }
+        }
+        std::sort(groups.begin(), groups.end(), [](const auto &a, const auto &b)
+                  { return a.first < b.first; });
+        return groups;
+    }
+};
+
+class AggregateStep : public Step
+{
+private:
+    // pointer to the csv file step whose rows are aggregated
+    CSVFileInputStep *sourceStep;
+    std::vector<size_t> groupColumns;
+    size_t valueColumn;
+    RowFilter filter;
+    bool skipHeader; // true when the first row holds the column names
+    std::vector<std::pair<std::vector<std::string>, AggregateValues>> results;
+
+    static const size_t MIN_ROWS_PER_PARTITION = 16384;
+
+    template <typename Cell>
+    std::vector<std::pair<std::vector<std::string>, AggregateValues>> aggregate(size_t firstRow, size_t rowCount) const
+    {
+        RowFilter rowFilter = filter;
+        rowFilter.prepare(*sourceStep);
+
+        // split the rows in partitions, every thread aggregates its partition in its own table
+        size_t partitionCount = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), rowCount / MIN_ROWS_PER_PARTITION));
+        std::vector<GroupHashTable<Cell>> partials(partitionCount);
+        MemoryAccount *account = MemoryAccount::getCurrent();
+        CancellationToken *token = CancellationToken::current;
+        auto aggregatePartition = [&](size_t partition)
+        {
+            MemoryAccountScope memoryScope(account);
+            CancellationScope cancellationScope(token);
+            size_t begin = firstRow + rowCount * partition / partitionCount;
+            size_t end = firstRow + rowCount * (partition + 1) / partitionCount;
+            for (size_t i = begin; i < end && !CancellationToken::stopRequested(); ++i)
+            {
+                if (rowFilter.matches(*sourceStep, i))
+                {
+                    partials[partition].add(*sourceStep, i, groupColumns, valueColumn);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t partition = 1; partition < partitionCount; ++partition)
+        {
+            workers.emplace_back(aggregatePartition, partition);
+        }
+        aggregatePartition(0);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        CancellationToken::check(); // the partitions stopped early hold partial groups
+
+        for (size_t partition = 1; partition < partitionCount; ++partition)
+        {
+            partials[0].merge(partials[partition]);
+        }
+        return partials[0].sortedGroups(sourceStep->getDictionaryTable());
+    }
+
+public:
+    AggregateStep(CSVFileInputStep *source, const std::vector<size_t> &groupColumns, size_t valueColumn, const RowFilter &filter, bool skipHeader)
+        : sourceStep(source), groupColumns(groupColumns), valueColumn(valueColumn), filter(filter), skipHeader(skipHeader)
+    {
+        std::vector<size_t> columns = groupColumns;
+        columns.push_back(valueColumn);
+        if (filter.op != FilterOperator::None)
+        {
+            columns.push_back(filter.column);
+        }
+        sourceStep->requireColumns(columns);
+        sourceStep->requireAllRows();
+    }
+
+    void execute() override
+    {
+        size_t firstRow = (skipHeader && sourceStep->getRowCount() > 0) ? 1 : 0;
+        size_t rowCount = sourceStep->getRowCount() - firstRow;
+        // encoded sources group by string ids, decoded only for the final groups, unless a group column is kept as text
+        const DictionaryTable *table = sourceStep->getDictionaryTable();
+        bool groupByIds = table != nullptr && std::all_of(groupColumns.begin(), groupColumns.end(), [table](size_t column)
+                                                          { return table->isColumnEncoded(column); });
+        results = groupByIds ? aggregate<uint32_t>(firstRow, rowCount) : aggregate<std::string>(firstRow, rowCount);
+
+        std::cout << "Aggregated " << rowCount << " rows into " << results.size() << " groups:" << std::endl;
+        for (const auto &group : results)
+        {
+            for (const std::string &cell : group.first)
+            {
+                std::cout << cell << " | ";
+            }
+            const AggregateValues &values = group.second;
+            std::cout << "count: " << values.count;
+            if (values.numericCount > 0)
+            {
+                std::cout << " | sum: " << formatNumber(values.sum) << " | min: " << formatNumber(values.min) << " | max: " << formatNumber(values.max) << " | avg: " << formatNumber(values.average());
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::string getType() const override
+    {
+        return "AGGREGATE";
+    }
+
+    const Step *getSource() const override
+    {
+        return sourceStep;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(sourceStep->fingerprint());
+        for (size_t column : groupColumns)
+        {
+            fingerprint.add(column);
+        }
+        fingerprint.add(groupColumns.size()).add(valueColumn).add(skipHeader);
+        fingerprint.add(static_cast<uint64_t>(filter.op)).add(filter.column).add(filter.value);
+    }
+
+    bool userInteraction() override
+    {
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step filters the rows of a CSV file and computes count, sum, min, max and average per group" << std::endl;
+    }
+
+    const std::vector<std::pair<std::vector<std::string>, AggregateValues>> &getResults() const
+    {
+        return results;
+    }
+
+    // the results as rows of text: the column names, then per group its values, count, sum, min, max and
+    // average (missing when no value of the group is numeric)
+    std::vector<std::vector<std::string>> getResultRows() const
+    {
+        std::vector<std::vector<std::string>> rows(1);
+        for (size_t column : groupColumns)
+        {
+            bool named = skipHeader && sourceStep->getRowCount() > 0 && sourceStep->hasCell(0, column);
+            rows[0].push_back(named ? std::string(sourceStep->getCell(0, column)) : "column " + formatNumber(column));
+        }
+        for (const char *name : {"count", "sum", "min", "max", "avg"})
+        {
+            rows[0].push_back(name);
+        }
+        for (const auto &group : results)
+        {
+            std::vector<std::string> row = group.first;
+            const AggregateValues &values = group.second;
+            row.push_back(formatNumber(values.count));
+            if (values.numericCount > 0)
+            {
+                for (double number : {values.sum, values.min, values.max, values.average()})
+                {
+                    row.push_back(formatNumber(number));
+                }
+            }
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+};
+
+class OutputStep : public Step
+{
+private:
+    int stepNumber;
+    std::string fileName;
+    std::string title;
+    std::string description;
+    std::vector<std::string> contentFromPreviousSteps;
+    OutputPipeline *outputPipeline; // when set, the record goes to the pipeline sinks instead of fileName
+    // columnar export: the rows of one of these steps are written to fileName in the columnar format
+    // instead of the record, for a CSV FILE INPUT step to map them back without parsing
+    Step *columnarSource;
+    const CSVFileInputStep *tableSource;
+    const AggregateStep *resultSource;
+    bool firstRowNames;
+
+    // informatii despre pas si continutul de la pasii respectivi, formatate o singura data
+    std::string formatRecord() const
+    {
+        std::string record = "Step Number: ";
+        appendNumber(record, stepNumber);
+        record += "\nTitle: " + title + "\nDescription: " + description + "\n";
+        for (const std::string &content : contentFromPreviousSteps)
+        {
+            record += content;
+            record += '\n';
+        }
+        return record;
+    }
+
+public:
+    OutputStep(int stepNumber, const std::string &fileName, const std::string &title, const std::string &description, const std::vector<std::string> &contentFromPreviousSteps) : stepNumber(stepNumber), fileName(fileName), title(title), description(description), contentFromPreviousSteps(contentFromPreviousSteps), outputPipeline(nullptr), columnarSource(nullptr), tableSource(nullptr), resultSource(nullptr), firstRowNames(false) {}
+
+    // columnar export of the table of a CSV FILE INPUT step (firstRowNames: its first row holds the column
+    // names) or of the results of an AGGREGATE step
+    OutputStep(int stepNumber, const std::string &fileName, const std::string &title, const std::string &description, Step *source, bool firstRowNames)
+        : stepNumber(stepNumber), fileName(fileName), title(title), description(description), outputPipeline(nullptr), columnarSource(source),
+          tableSource(dynamic_cast<const CSVFileInputStep *>(source)), resultSource(dynamic_cast<const AggregateStep *>(source)), firstRowNames(firstRowNames || resultSource)
+    {
+        if (CSVFileInputStep *csvSource = dynamic_cast<CSVFileInputStep *>(source))
+        {
+            csvSource->requireAllRows();
+        }
+    }
+
+    void execute() override
+    {
+        std::cout << "Executing OutputStep: " << std::endl;
+        if (tableSource || resultSource)
+        {
+            bool written = tableSource ? ColumnarWriter::write(fileName, *tableSource, firstRowNames) : ColumnarWriter::write(fileName, RowTable(resultSource->getResultRows()), true);
+            if (written)
+            {
+                std::cout << "Columnar file '" << fileName << "' generated successfully" << std::endl;
+            }
+            else
+            {
+                std::cerr << "Erorr!! Unable to create output file '" << fileName << "'!" << std::endl;
+            }
+            return;
+        }
+        if (outputPipeline)
+        {
+            if (outputPipeline->publish(formatRecord()))
+            {
+                std::cout << "Output record published to the output sinks" << std::endl;
+            }
+            else
+            {
+                std::cerr << "Error: The output sinks are closed, the output record was not published." << std::endl;
+            }
+            return;
+        }
+        TraceScope ioScope("io", "write ", fileName);
+        std::ofstream outputFile(fileName);
+        if (outputFile.is_open())
+        {
+            // scrie informatii despre pas si continutul de la pasii respectivi in fisier
+            outputFile << formatRecord();
+            outputFile.close();
+            std::cout << "Output file '" << fileName << "' generated successfully" << std::endl;
+        }
+        else
+        {
+            std::cerr << "Erorr!! Unable to create output file '" << fileName << "'!" << std::endl;
+        }
+    }
+
+    std::string getType() const override
+    {
+        return "OUTPUT";
+    }
+
+    const Step *getSource() const override
+    {
+        return columnarSource;
+    }
+
+    void addFingerprint(Fingerprint &fingerprint) const override
+    {
+        fingerprint.add(static_cast<uint64_t>(stepNumber)).add(fileName).add(title).add(description);
+        if (columnarSource)
+        {
+            fingerprint.add(columnarSource->fingerprint()).add(firstRowNames);
+        }
+    }
+
+    void setOutputPipeline(OutputPipeline *pipeline) override
+    {
+        outputPipeline = pipeline;
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "Step number: " << stepNumber << std::endl;
+        std::cout << "File Name: " << fileName << std::endl;
+        std::cout << "Title: " << title << std::endl;
+        std::cout << "Description: " << description << std::endl;
+        if (columnarSource)
+        {
+            std::cout << "Columnar export of the " << columnarSource->getType() << " step" << std::endl;
+        }
+
+        // display content from previous steps
+        for (const std::string &content : contentFromPreviousSteps)
+        {
+            std::cout << content << std::endl;
+        }
+    }
+
+    bool userInteraction() override
+    {
+        // add logic for user interaction specific to TextStep
+        std::cout << "Press 'N' to skip to the next step or any other key to continue: ";
+        char choice;
+        std::cin >> choice;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+        return (choice != 'N' && choice != 'n');
+    }
+};
+
+class EndStep : public Step
+{
+public:
+    void execute() override
+    {
+        std::cout << "End of the flow\n";
+    }
+
+    std::string getType() const override
+    {
+        return "END";
+    }
+
+    void displayDescription() const override
+    {
+        std::cout << "This step is the end of the flow" << std::endl;
+    }
+};
+
+// analytics counters of a flow, shared by ProcessBuilder and StaticFlow
+class FlowAnalytics
+{
+private:
+    int startCount;
+    int completionCount;
+    std::unordered_map<std::string, int> screenSkipCount;  // count of skipped screens for each step type
+    std::unordered_map<std::string, int> errorScreenCount; // count for error screens for each step type
+    int totalErrorCount;
+
+    // hardware counters summed per step type, with the number of sampled executions
+    bool perfCountersEnabled;
+    bool perfCountersAvailable;
+    std::unordered_map<std::string, std::pair<int, PerfCounterValues>> perfCountersPerStep;
+
+    std::optional<uint64_t> lastRunAllocations; // heap allocations of the last completed run, 0 once the run reuses its memory; empty if not measured
+
+public:
+    FlowAnalytics() : startCount(0), completionCount(0), totalErrorCount(0), perfCountersEnabled(false), perfCountersAvailable(false) {}
+
+    void recordStart()
+    {
+        startCount++;
+    }
+
+    void recordCompletion()
+    {
+        completionCount++;
+    }
+
+    void recordSkip(const std::string &stepType)
+    {
+        screenSkipCount[stepType]++;
+    }
+
+    // function to report an error for a specific step type
+    void reportError(const std::string &stepType)
+    {
+        errorScreenCount[stepType]++;
+        totalErrorCount++;
+    }
+
+    void setPerfCountersStatus(bool enabled, bool available)
+    {
+        perfCountersEnabled = enabled;
+        perfCountersAvailable = available;
+    }
+
+    void recordPerfCounters(const std::string &stepType, const PerfCounterValues &values)
+    {
+        auto &entry = perfCountersPerStep[stepType];
+        entry.first++;
+        entry.second += values;
+    }
+
+    int getTotalErrorCount() const
+    {
+        return totalErrorCount;
+    }
+
+    void recordAllocations(uint64_t allocations)
+    {
+        lastRunAllocations = allocations;
+    }
+
+    // adds the result of a calculus step to the error screen count of its type
+    void addErrorScreens(const std::string &stepType, float amount)
+    {
+        errorScreenCount[stepType] += amount;
+    }
+
+    // function to display analytics for the flow
+    void display(const std::string &flowName) const
+    {
+        std::cout << "Analytics for flow '" << flowName << "':" << std::endl;
+        std::cout << "Flow started: " << startCount << " times" << std::endl;
+        std::cout << "Flow completed: " << completionCount << " times" << std::endl;
+
+        std::cout << "Screen skip counts:" << std::endl;
+        for (const auto &entry : screenSkipCount)
+        {
+            std::cout << entry.first << ": " << entry.second << " times" << std::endl;
+        }
+
+        std::cout << "Error screen counts:" << std::endl;
+        for (const auto &entry : errorScreenCount)
+        {
+            std::cout << entry.first << ": " << entry.second << " times" << std::endl;
+        }
+
+        if (perfCountersEnabled)
+        {
+            displayPerfCounters();
+        }
+
+        if (completionCount > 0)
+        {
+            double averageErrors = static_cast<double>(totalErrorCount) / completionCount;
+            std::cout << "Average number of errors per flow completed: " << averageErrors << std::endl;
+            if (lastRunAllocations)
+            {
+                std::cout << "Heap allocations in the last completed run: " << *lastRunAllocations << std::endl;
+            }
+        }
+        else
+        {
+            std::cout << "Average number of errors per flow completed: N/A (no completions)" << std::endl;
+        }
+    }
+
+    // average hardware counters per execution of each step type
+    void displayPerfCounters() const
+    {
+        std::cout << "Hardware counters per step execution:" << std::endl;
+        if (!perfCountersAvailable)
+        {
+            std::cout << "N/A (performance counters are not available on this host)" << std::endl;
+            return;
+        }
+        for (const auto &entry : perfCountersPerStep)
+        {
+            int executions = entry.second.first;
+            const PerfCounterValues &total = entry.second.second;
+            double ipc = total.cycles > 0 ? static_cast<double>(total.instructions) / total.cycles : 0.0;
+            std::cout << entry.first << ": " << executions << " executions, "
+                      << total.cycles / executions << " cycles, "
+                      << total.instructions / executions << " instructions (IPC " << std::fixed << std::setprecision(2) << ipc << std::defaultfloat << "), "
+                      << total.cacheMisses / executions << " cache misses, "
+                      << total.branchMisses / executions << " branch misses" << std::endl;
+        }
+    }
+
+    void reset()
+    {
+        perfCountersPerStep.clear();
+        startCount = 0;
+        completionCount = 0;
+        screenSkipCount.clear();
+        errorScreenCount.clear();
+        totalErrorCount = 0;
+        lastRunAllocations.reset();
+    }
+};
+
+// one run of a flow, as stored in the analytics time series. Fixed width so the file can be scanned
+// in place; the fields are in native byte order
+struct RunRecord
+{
+    int64_t timestampMicros; // start of the run, microseconds since the epoch
+    uint64_t flowId;         // fingerprint of the flow name
+    int64_t durationMicros;  // whole run, waits for user input included
+    int64_t stepMicros;      // time spent executing steps
+    uint32_t executedSteps;
+    uint32_t skippedSteps;
+    uint32_t errors;
+    uint32_t completed; // 1 when the run reached the end of the flow
+};
+static_assert(sizeof(RunRecord) == 48, "RunRecord is stored as is");
+
+// append-only file of RunRecords after a 16 byte header (magic, version, record size). Recording a run is
+// a single write; queries map the file and group the runs of a time window per minute, hour or day
+class AnalyticsStore
+{
+private:
+    std::string fileName;
+
+    static constexpr char MAGIC[8] = {'F', 'L', 'O', 'W', 'T', 'S', '0', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static const size_t HEADER_SIZE = 16;
+
+    static bool validHeader(const char *data, size_t size)
+    {
+        uint32_t version, recordSize;
+        if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            return false;
+        }
+        memcpy(&version, data + 8, 4);
+        memcpy(&recordSize, data + 12, 4);
+        return version == VERSION && recordSize == sizeof(RunRecord);
+    }
+
+    struct Bucket
+    {
+        size_t runs = 0;
+        size_t completed = 0;
+        uint64_t executedSteps = 0;
+        uint64_t skippedSteps = 0;
+        uint64_t errors = 0;
+        int64_t durationMicros = 0;
+        int64_t maxDurationMicros = 0;
+        int64_t stepMicros = 0;
+    };
+
+public:
+    explicit AnalyticsStore(const std::string &fileName) : fileName(fileName) {}
+
+    static uint64_t flowId(const std::string &flowName)
+    {
+        return Fingerprint().add(flowName).digest();
+    }
+
+    bool append(const RunRecord &record) const
+    {
+        char buffer[HEADER_SIZE + sizeof(RunRecord)];
+        uint32_t version = VERSION, recordSize = sizeof(RunRecord);
+        memcpy(buffer, MAGIC, sizeof(MAGIC));
+        memcpy(buffer + 8, &version, 4);
+        memcpy(buffer + 12, &recordSize, 4);
+        memcpy(buffer + HEADER_SIZE, &record, sizeof(RunRecord));
+#ifdef __linux__
+        // the processes that record runs at once take turns on an exclusive lock, so only the first one
+        // writes the header and every record starts at HEADER_SIZE plus a multiple of sizeof(RunRecord)
+        int fd = ::open(fileName.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat status;
+        char header[HEADER_SIZE];
+        bool ready = flock(fd, LOCK_EX) == 0 && fstat(fd, &status) == 0 &&
+                     (status.st_size == 0 || (pread(fd, header, HEADER_SIZE, 0) == static_cast<ssize_t>(HEADER_SIZE) && validHeader(header, HEADER_SIZE)));
+        if (ready && status.st_size > 0)
+        {
+            // drop a record cut by a writer that died, otherwise all the next ones would be read shifted
+            off_t partial = (status.st_size - static_cast<off_t>(HEADER_SIZE)) % static_cast<off_t>(sizeof(RunRecord));
+            ready = partial == 0 || ftruncate(fd, status.st_size - partial) == 0;
+        }
+        bool written = false;
+        if (ready)
+        {
+            const char *data = status.st_size == 0 ? buffer : buffer + HEADER_SIZE; // the header starts a new file
+            size_t size = buffer + sizeof(buffer) - data;
+            written = ::write(fd, data, size) == static_cast<ssize_t>(size);
+        }
+        ::close(fd); // also releases the lock
+        return written;
+#else
+        std::ofstream file(fileName, std::ios::binary | std::ios::app);
+        file.seekp(0, std::ios::end);
+        const char *data = file.tellp() == 0 ? buffer : buffer + HEADER_SIZE;
+        return static_cast<bool>(file.write(data, buffer + sizeof(buffer) - data));
+#endif
+    }
+
+    // calls visit(record) for every run stored in the file; false when the file cannot be read
+    template <typename Visit>
+    bool scan(Visit &&visit) const
+    {
+#ifdef __linux__
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(HEADER_SIZE))
+        {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(status.st_size);
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            return false;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        const char *data = static_cast<const char *>(mapped);
+#else
+        std::ifstream file(fileName, std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const char *data = contents.data();
+        size_t size = contents.size();
+#endif
+        bool valid = validHeader(data, size);
+        if (valid)
+        {
+            for (size_t offset = HEADER_SIZE; offset + sizeof(RunRecord) <= size; offset += sizeof(RunRecord))
+            {
+                RunRecord record;
+                memcpy(&record, data + offset, sizeof(RunRecord));
+                visit(record);
+            }
+        }
+#ifdef __linux__
+        munmap(mapped, size);
+#endif
+        return valid;
+    }
+
+    // runs, completions, skip and error rates and durations per bucket of bucketSeconds, for the runs of
+    // [fromSeconds, toSeconds) of one flow (all flows when flowName is empty)
+    bool query(const std::string &flowName, int64_t fromSeconds, int64_t toSeconds, int64_t bucketSeconds) const
+    {
+        uint64_t id = flowId(flowName);
+        std::map<int64_t, Bucket> buckets;
+        bool read = scan([&](const RunRecord &record)
+                         {
+            int64_t seconds = record.timestampMicros / 1000000;
+            if (seconds < fromSeconds || seconds >= toSeconds || (!flowName.empty() && record.flowId != id))
+            {
+                return;
+            }
+            Bucket &bucket = buckets[seconds - seconds % bucketSeconds];
+            bucket.runs++;
+            bucket.completed += record.completed;
+            bucket.executedSteps += record.executedSteps;
+            bucket.skippedSteps += record.skippedSteps;
+            bucket.errors += record.errors;
+            bucket.durationMicros += record.durationMicros;
+            bucket.maxDurationMicros = std::max(bucket.maxDurationMicros, record.durationMicros);
+            bucket.stepMicros += record.stepMicros; });
+        if (!read)
+        {
+            std::cerr << "Error: '" << fileName << "' is not an analytics file" << std::endl;
+            return false;
+        }
+
+        std::cout << "Bucket (UTC)      | runs | completed | skip rate | errors/run | avg run ms | max run ms | avg step time ms" << std::endl;
+        for (const auto &entry : buckets)
+        {
+            const Bucket &bucket = entry.second;
+            time_t start = static_cast<time_t>(entry.first);
+            char label[32];
+            std::strftime(label, sizeof(label), "%Y-%m-%d %H:%M", std::gmtime(&start));
+            uint64_t offered = bucket.executedSteps + bucket.skippedSteps;
+            std::cout << label << "  | " << bucket.runs << " | " << bucket.completed << std::fixed << std::setprecision(3)
+                      << " | " << (offered > 0 ? static_cast<double>(bucket.skippedSteps) / offered : 0.0)
+                      << " | " << static_cast<double>(bucket.errors) / bucket.runs
+                      << " | " << bucket.durationMicros / 1000.0 / bucket.runs
+                      << " | " << bucket.maxDurationMicros / 1000.0
+                      << " | " << bucket.stepMicros / 1000.0 / bucket.runs << std::defaultfloat << std::endl;
+        }
+        if (buckets.empty())
+        {
+            std::cout << "No runs in this window" << std::endl;
+        }
+        return true;
+    }
+};
+
+// samples the hardware counters around one step execution, does nothing when counters is null
+class PerfCounterScope
+{
+private:
+    PerfCounters *counters;
+    FlowAnalytics &analytics;
+    std::string stepType;
+
+public:
+    PerfCounterScope(PerfCounters *counters, FlowAnalytics &analytics, const std::string &stepType) : counters(counters && counters->isAvailable() ? counters : nullptr), analytics(analytics)
+    {
+        if (this->counters)
+        {
+            this->stepType = stepType;
+            this->counters->start();
+        }
+    }
+
+    PerfCounterScope(const PerfCounterScope &) = delete;
+    PerfCounterScope &operator=(const PerfCounterScope &) = delete;
+
+    ~PerfCounterScope()
+    {
+        if (counters)
+        {
+            analytics.recordPerfCounters(stepType, counters->stop());
+        }
+    }
+};
+
+// what runFlow does with a step of the plan besides executing it
+enum class PlanOperation
+{
+    Execute,
+    Output,           // records the content of the output step
+    Calculus,         // adds the result to the error screen count of the step
+    DisplayFromMemory // display of the CSV INPUT step planned just before it, fused with it
+};
+
+struct PlannedStep
+{
+    size_t index; // position of the step in the flow
+    Step *step;
+    std::string type;
+    PlanOperation operation;
+    const CalculusStep *calculusStep;
+    DisplayStep *displayStep;
+};
+
+// the steps of a flow as runFlow executes them, prepared once instead of on every run: the type of every
+// step is read once, the steps are validated and resolved to the operation around them, trailing END
+// steps are dropped, and so are TITLE and TEXT steps in headless runs, where nobody reads their output.
+// A DISPLAY step that shows the file just saved by the CSV INPUT step before it is fused with that
+// step: when the CSV INPUT step has executed, its data is displayed from memory instead of read back
+class FlowPlan
+{
+private:
+    std::vector<PlannedStep> plannedSteps;
+    const CalculusStep *finalCalculus; // last step of the flow when it is a calculus step, its result ends the run
+    bool prepared;
+    bool headless;
+    bool valid;
+
+public:
+    FlowPlan() : finalCalculus(nullptr), prepared(false), headless(false), valid(false) {}
+
+    // false when the flow is invalid: a step reads a step that is not before it in the flow
+    bool prepare(const std::vector<Step *> &steps, bool headlessRun)
+    {
+        if (prepared && headless == headlessRun)
+        {
+            return valid;
+        }
+        plannedSteps.clear();
+        prepared = true;
+        headless = headlessRun;
+        valid = true;
+        finalCalculus = steps.empty() ? nullptr : dynamic_cast<const CalculusStep *>(steps.back());
+
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            const Step *source = steps[i]->getSource();
+            if (source && std::find(steps.begin(), steps.begin() + i, source) == steps.begin() + i)
+            {
+                std::cerr << "Invalid flow. Step " << i + 1 << " (" << steps[i]->getType() << ") reads a step that is not before it in the flow." << std::endl;
+                valid = false;
+            }
+        }
+
+        size_t end = steps.size();
+        while (end > 0 && dynamic_cast<const EndStep *>(steps[end - 1]))
+        {
+            --end;
+        }
+        for (size_t i = 0; i < end; ++i)
+        {
+            Step *step = steps[i];
+            if (headless && (dynamic_cast<const TitleStep *>(step) || dynamic_cast<const TextStep *>(step)))
+            {
+                continue;
+            }
+            PlannedStep planned{i, step, step->getType(), PlanOperation::Execute, nullptr, nullptr};
+            if (dynamic_cast<const OutputStep *>(step))
+            {
+                planned.operation = PlanOperation::Output;
+            }
+            else if ((planned.calculusStep = dynamic_cast<const CalculusStep *>(step)))
+            {
+                planned.operation = PlanOperation::Calculus;
+            }
+            else if ((planned.displayStep = dynamic_cast<DisplayStep *>(step)) && planned.displayStep->canDisplayFromMemory() && !plannedSteps.empty() && plannedSteps.back().step == step->getSource())
+            {
+                planned.operation = PlanOperation::DisplayFromMemory;
+            }
+            plannedSteps.push_back(std::move(planned));
+        }
+        return valid;
+    }
+
+    // the steps changed, the next run prepares the plan again
+    void invalidate()
+    {
+        prepared = false;
+    }
+
+    const std::vector<PlannedStep> &getSteps() const
+    {
+        return plannedSteps;
+    }
+
+    const CalculusStep *getFinalCalculus() const
+    {
+        return finalCalculus;
+    }
+};
+
+// takes the place of the user at the terminal during a run, see ProcessBuilder::runFlow
+class RunDriver
+{
+public:
+    // true to execute the step, false to skip it
+    virtual bool chooseStep(size_t index, const Step &step) = 0;
+    // calls execute, with the input of the step bound to std::cin
+    virtual void executeStep(size_t index, const Step &step, const std::function<void()> &execute) = 0;
+    virtual ~RunDriver() = default;
+};
+
+class ProcessBuilder
+{
+private:
+    std::vector<Step *> steps; // vector to held steps in the flow
+    std::string flowName;
+    time_t creationTimestamp;
+
+    FlowPlan plan; // prepared on the first run, again after the steps change
+
+    // deadlines of every step and of the whole run (zero = none), checked by the loops of the steps
+    std::chrono::milliseconds stepTimeout;
+    std::chrono::milliseconds flowTimeout;
+    TimeoutPolicy timeoutPolicy;
+
+    // Analytics
+    FlowAnalytics analytics;
+    std::unique_ptr<PerfCounters> perfCounters; // set only when hardware counter sampling is enabled
+
+    // content collected during a run; the strings are kept between runs and overwritten, contentCount are valid
+    std::vector<std::string> contentFromPreviousSteps;
+    size_t contentCount;
+
+    // memory allocated by the flow and by each of its steps, created on the first run of the step
+    MemoryAccount *memoryAccount;
+    std::vector<MemoryAccount *> stepMemory;
+
+    MemoryAccount *stepMemoryAccount(size_t index)
+    {
+        if (stepMemory.size() < steps.size())
+        {
+            stepMemory.resize(steps.size(), nullptr);
+        }
+        if (!stepMemory[index])
+        {
+            stepMemory[index] = MemoryAccount::create(steps[index]->getType(), memoryAccount);
+        }
+        return stepMemory[index];
+    }
+
+    // when set, every run is appended to this time series
+    std::unique_ptr<AnalyticsStore> analyticsStore;
+
+    void storeRun(RunRecord &run, int errorsAtStart, std::chrono::steady_clock::time_point runStart, bool completed)
+    {
+        if (!analyticsStore)
+        {
+            return;
+        }
+        run.durationMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - runStart).count();
+        run.errors = static_cast<uint32_t>(analytics.getTotalErrorCount() - errorsAtStart);
+        run.completed = completed ? 1 : 0;
+        if (!analyticsStore->append(run))
+        {
+            std::cerr << "Warning: unable to record the run in the analytics store" << std::endl;
+        }
+    }
+
+    // record duplicates are searched when the analytics are displayed, only once enabled
+    bool duplicateDetection;
+    DuplicateMode duplicateMode;
+    size_t expectedRecords;
+
+    void displayDuplicateSteps() const
+    {
+        std::vector<std::pair<size_t, size_t>> duplicates = findDuplicateSteps();
+        std::cout << "Duplicate steps:" << (duplicates.empty() ? " none" : "") << std::endl;
+        for (const auto &duplicate : duplicates)
+        {
+            std::cout << "Step " << duplicate.second + 1 << " (" << steps[duplicate.second]->getType() << ") is the same as step " << duplicate.first + 1 << std::endl;
+        }
+    }
+
+    // one detector for all the steps, so a record repeated in a later step counts for that step
+    void displayDuplicateRecords() const
+    {
+        DuplicateDetector detector(duplicateMode, expectedRecords);
+        std::cout << "Duplicate records" << (duplicateMode == DuplicateMode::Bloom ? " (approximate):" : ":") << std::endl;
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            size_t records = detector.getRecordCount();
+            size_t duplicates = detector.getDuplicateCount();
+            steps[i]->fingerprintRecords([&detector](uint64_t fingerprint)
+                                         { detector.add(fingerprint); });
+            if (detector.getRecordCount() > records)
+            {
+                std::cout << "Step " << i + 1 << " " << steps[i]->getType() << ": " << detector.getDuplicateCount() - duplicates << " of " << detector.getRecordCount() - records << " records" << std::endl;
+            }
+        }
+        std::cout << "Total: " << detector.getDuplicateCount() << " of " << detector.getRecordCount() << " records" << std::endl;
+    }
+
+    void displayMemoryUsage() const
+    {
+        std::cout << "Memory in use: " << memoryAccount->getCurrentBytes() << " bytes, peak: " << memoryAccount->getPeakBytes() << " bytes";
+        if (memoryAccount->getBudget() > 0)
+        {
+            std::cout << " (budget: " << memoryAccount->getBudget() << " bytes, " << (memoryAccount->getPolicy() == MemoryBudgetPolicy::FailFast ? "fail fast" : "stream") << ")";
+        }
+        std::cout << std::endl;
+        for (size_t i = 0; i < stepMemory.size(); ++i)
+        {
+            if (stepMemory[i])
+            {
+                std::cout << "Step " << i + 1 << " " << stepMemory[i]->getName() << ": " << stepMemory[i]->getCurrentBytes() << " bytes in use, peak: " << stepMemory[i]->getPeakBytes() << " bytes" << std::endl;
+            }
+        }
+    }
+
+    void addContent(const char *content)
+    {
+        if (contentCount < contentFromPreviousSteps.size())
+        {
+            contentFromPreviousSteps[contentCount].assign(content);
+        }
+        else
+        {
+            contentFromPreviousSteps.emplace_back(content);
+        }
+        contentCount++;
+    }
+
+public:
+    // constructor to initialize the creation timestamp
+    ProcessBuilder() : stepTimeout(0), flowTimeout(0), timeoutPolicy(TimeoutPolicy::Continue), contentCount(0), memoryAccount(MemoryAccount::create("flow")), duplicateDetection(false), duplicateMode(DuplicateMode::Exact), expectedRecords(0)
+    {
+        creationTimestamp = time(nullptr); // set the creation time stamp to the current time
+    }
+
+    // destructor to clean up allocated steps
+    ~ProcessBuilder()
+    {
+        for (Step *step : steps)
+        {
+            delete step;
+        }
+    }
+
+    void setFlowName(const std::string &name)
+    {
+        flowName = name;
+    }
+
+    std::string getFlowName() const
+    {
+        return flowName;
+    }
+
+    size_t getStepCount() const
+    {
+        return steps.size();
+    }
+
+    std::string getStepType(size_t index) const
+    {
+        return steps[index]->getType();
+    }
+
+    // function to add a step to the flow, permite adaugarea oricarui tip de pasi
+    template <typename T, typename... Args>
+    void addStep(Args &&...args)
+    {
+        steps.push_back(new T(std::forward<Args>(args)...));
+        plan.invalidate();
+    }
+
+    // without a driver the choices and the input of the steps are read from std::cin; with a driver the run
+    // is headless: no prompts, and the steps whose only effect is their output are left out of the plan.
+    // Returns true when the run went through all the steps
+    bool runFlow(RunDriver *driver = nullptr)
+    {
+        bool headless = driver != nullptr;
+        if (!plan.prepare(steps, headless))
+        {
+            std::cerr << "Flow '" << flowName << "' is not run." << std::endl;
+            return false;
+        }
+        analytics.recordStart();
+        std::cout << "Running flow '" << flowName << "' created at: " << std::asctime(std::localtime(&creationTimestamp));
+
+        uint64_t allocationsAtStart = memoryAccount->getAllocationCount();
+        MemoryAccountScope flowMemoryScope(memoryAccount);
+        std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+        int errorsAtStart = analytics.getTotalErrorCount();
+        RunRecord run{};
+        run.timestampMicros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        run.flowId = AnalyticsStore::flowId(flowName);
+        contentCount = 0;
+        bool previousExecuted = false; // the previous step of the plan executed in this run
+        std::chrono::steady_clock::time_point noDeadline = std::chrono::steady_clock::time_point::max();
+        std::chrono::steady_clock::time_point flowDeadline = flowTimeout.count() > 0 ? runStart + flowTimeout : noDeadline;
+
+        // parcurgem pasii planului si ii executa, afisand pasul curent
+        for (const PlannedStep &planned : plan.getSteps())
+        {
+            Step *currentStep = planned.step;
+            char userChoice;
+            if (driver)
+            {
+                userChoice = driver->chooseStep(planned.index, *currentStep) ? 'y' : 'n';
+            }
+            else
+            {
+                std::cout << "Executing step: " << planned.type << std::endl;
+                // prompt user to decide if he wants to execute a step or to skip it
+                std::cout << "Do you want to execute this step? (y/n): ";
+                TraceScope waitScope("wait", "step choice");
+                std::cin >> userChoice;
+            }
+            if (!driver && !std::cin)
+            {
+                std::cout << std::endl
+                          << "No more input, the flow is stopped." << std::endl;
+                storeRun(run, errorsAtStart, runStart, false);
+                return false;
+            }
+            if (userChoice != 'Y' && userChoice != 'y')
+            {
+                if (!headless)
+                {
+                    std::cout << "Skipping to the next step..." << std::endl;
+                }
+                analytics.recordSkip(planned.type);
+                run.skippedSteps++;
+                previousExecuted = false;
+                continue;
+            }
+
+            bool stopRun = false;            // the step ran past a deadline after which the run does not go on
+            bool flowDeadlinePassed = false;
+            {
+                TraceScope stepScope("step", planned.type);
+                PerfCounterScope perfScope(perfCounters.get(), analytics, planned.type);
+                MemoryAccountScope stepMemoryScope(stepMemoryAccount(planned.index));
+                std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+                CancellationToken cancellationToken(stepTimeout.count() > 0 ? stepStart + stepTimeout : noDeadline, flowDeadline);
+                CancellationScope cancellationScope(&cancellationToken);
+                // the fused display reads the data of the CSV INPUT step only if that step just saved it
+                bool fromMemory = planned.operation == PlanOperation::DisplayFromMemory && previousExecuted && static_cast<const CSVInputStep *>(currentStep->getSource())->isSavedToFile();
+                auto execute = [&planned, fromMemory]()
+                {
+                    if (fromMemory)
+                    {
+                        planned.displayStep->displayFromMemory();
+                    }
+                    else
+                    {
+                        planned.step->execute();
+                    }
+                };
+                previousExecuted = false;
+                try
+                {
+                    if (driver)
+                    {
+                        driver->executeStep(planned.index, *currentStep, execute);
+                    }
+                    else
+                    {
+                        execute();
+                    }
+                    previousExecuted = true;
+                }
+                catch (const MemoryBudgetExceeded &error)
+                {
+                    std::cerr << "Error: " << error.what() << std::endl;
+                    analytics.reportError(planned.type);
+                }
+                catch (const StepTimeout &timeout)
+                {
+                    std::cerr << "Error: step " << planned.type << " stopped, " << timeout.what() << std::endl;
+                    analytics.reportError(planned.type);
+                    flowDeadlinePassed = timeout.isFlowDeadline();
+                    stopRun = flowDeadlinePassed || timeoutPolicy == TimeoutPolicy::Abort;
+                }
+                run.stepMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - stepStart).count();
+                run.executedSteps++;
+            }
+            if (!stopRun && std::chrono::steady_clock::now() >= flowDeadline)
+            {
+                stopRun = flowDeadlinePassed = true; // the next steps could not even start
+            }
+            if (stopRun)
+            {
+                std::cout << std::endl
+                          << "The flow is stopped, the deadline of the " << (flowDeadlinePassed ? "flow" : "step") << " passed." << std::endl;
+                storeRun(run, errorsAtStart, runStart, false);
+                return false;
+            }
+
+            if (planned.operation == PlanOperation::Output)
+            {
+                // extract content from the OUTPUT step and store it
+                currentStep->displayDescription(); // display OUTPUT step details
+                addContent("Content from output step");
+            }
+            else if (planned.operation == PlanOperation::Calculus)
+            {
+                // Update error screen count for CALCULUS step
+                analytics.addErrorScreens(planned.type, planned.calculusStep->getResult());
+            }
+
+            if (!headless)
+            {
+                // wait for user confirmation to proceed to the next step
+                std::cout << "Press enter to proceed to the next step...";
+                TraceScope waitScope("wait", "proceed");
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            }
+        }
+
+        // daca ultimul pas e de tip calculus, afiseaza rezultatul final
+        if (const CalculusStep *lastCalculusStep = plan.getFinalCalculus())
+        {
+            std::cout << "Final Result: " << formatNumber(lastCalculusStep->getResult()) << std::endl;
+        }
+
+        analytics.recordCompletion();
+        analytics.recordAllocations(memoryAccount->getAllocationCount() - allocationsAtStart);
+        storeRun(run, errorsAtStart, runStart, true);
+        std::cout << "Flow completed." << std::endl;
+        return true;
+    }
+
+    // function to report an error for a specific step type
+    void reportError(const std::string &stepType)
+    {
+        analytics.reportError(stepType);
+    }
+
+    // samples cycles, instructions, cache misses and branch misses around every step execution
+    void enablePerfCounters()
+    {
+        perfCounters = std::make_unique<PerfCounters>();
+        analytics.setPerfCountersStatus(true, perfCounters->isAvailable());
+        if (!perfCounters->isAvailable())
+        {
+            std::cerr << "Warning: hardware performance counters are not available, continuing without them." << std::endl;
+        }
+    }
+
+    // function to display analytics for the flow
+    void displayAnalytics() const
+    {
+        analytics.display(flowName);
+        displayMemoryUsage();
+        displayDuplicateSteps();
+        if (duplicateDetection)
+        {
+            displayDuplicateRecords();
+        }
+    }
+
+    // pairs (first step, later step with the same type and parameters), found in one pass over the steps
+    std::vector<std::pair<size_t, size_t>> findDuplicateSteps() const
+    {
+        std::vector<std::pair<size_t, size_t>> duplicates;
+        std::unordered_map<uint64_t, size_t> firstSteps;
+        for (size_t i = 0; i < steps.size(); ++i)
+        {
+            auto inserted = firstSteps.emplace(steps[i]->fingerprint(), i);
+            if (!inserted.second)
+            {
+                duplicates.emplace_back(inserted.first->second, i);
+            }
+        }
+        return duplicates;
+    }
+
+    // fingerprint of the whole flow, equal for flows with the same steps in the same order
+    uint64_t fingerprint() const
+    {
+        Fingerprint fingerprint;
+        for (const Step *step : steps)
+        {
+            fingerprint.add(step->fingerprint());
+        }
+        return fingerprint.add(steps.size()).digest();
+    }
+
+    // adds a report of the repeated CSV rows and text inputs to the analytics; expectedRecords sizes the
+    // Bloom filter of the approximate mode
+    void enableDuplicateDetection(DuplicateMode mode, size_t expected = 1 << 20)
+    {
+        duplicateDetection = true;
+        duplicateMode = mode;
+        expectedRecords = expected;
+    }
+
+    // appends every run of the flow to a time series file, see AnalyticsStore
+    void setAnalyticsStore(const std::string &fileName)
+    {
+        analyticsStore = std::make_unique<AnalyticsStore>(fileName);
+    }
+
+    // a step running longer than step stops and counts as an error, after which the run goes on or aborts
+    // per policy; a run longer than flow always aborts. Zero durations disable the deadlines
+    void setTimeouts(std::chrono::milliseconds step, std::chrono::milliseconds flow, TimeoutPolicy policy)
+    {
+        stepTimeout = step;
+        flowTimeout = flow;
+        timeoutPolicy = policy;
+    }
+
+    // bytes the flow may allocate before its steps stream their input or fail, 0 for no budget
+    void setMemoryBudget(size_t bytes, MemoryBudgetPolicy policy)
+    {
+        memoryAccount->setBudget(bytes, policy);
+    }
+
+    // function to delete a flow
+    void deleteFlow(const std::string &flowToDelete)
+    {
+        // check if the flow we eant to delete matches the current flow
+        if (flowToDelete == flowName)
+        {
+            throw "Deleting flow";
+            std::cout << flowToDelete << "'..." << std::endl;
+            // clean up allocated steps
+            for (Step *step : steps)
+            {
+                delete step;
+            }
+            // clear the step vector
+            steps.clear();
+            plan.invalidate();
+            // reset analytics
+            analytics.reset();
+            // reset flow name
+            flowName.clear();
+        }
+        else
+        {
+            std::cerr << "Error!!! Flow '" << flowToDelete << "' not found" << std::endl;
+        }
+    }
+
+    // sends the output of the OUTPUT and CSV INPUT steps to the sinks of the pipeline
+    void setOutputPipeline(OutputPipeline *pipeline)
+    {
+        for (Step *step : steps)
+        {
+            step->setOutputPipeline(pipeline);
+        }
+    }
+
+    // returns the last step of the given type added to the flow, or nullptr
+    Step *findLastStep(const std::string &stepType) const
+    {
+        for (auto it = steps.rbegin(); it != steps.rend(); ++it)
+        {
+            if ((*it)->getType() == stepType)
+            {
+                return *it;
+            }
+        }
+        return nullptr;
+    }
+
+    void displayAvailableSteps() const
+    {
+        std::cout << "Available steps: " << std::endl;
+        for (const Step *step : steps)
+        {
+            std::cout << "- Type: " << step->getType() << std::endl;
+            step->displayDescription();
+            std::cout << std::endl;
+        }
+    }
+
+    std::string getCreationTimestamp() const
+    {
+        return std::asctime(std::localtime(&creationTimestamp)); // Convert timestamp to a readable string
+    }
+};
+
+// slot holding one step of a static flow, constructed in place from a tuple of constructor arguments
+template <size_t Index, typename T>
+class StaticFlowSlot
+{
+protected:
+    T step;
+
+public:
+    template <typename ArgsTuple>
+    explicit StaticFlowSlot(ArgsTuple &&args) : step(std::make_from_tuple<T>(std::forward<ArgsTuple>(args))) {}
+};
+
+template <typename Indices, typename... Steps>
+class StaticFlowSteps;
+
+template <size_t... Indices, typename... Steps>
+class StaticFlowSteps<std::index_sequence<Indices...>, Steps...> : protected StaticFlowSlot<Indices, Steps>...
+{
+protected:
+    template <typename... ArgsTuples>
+    explicit StaticFlowSteps(ArgsTuples &&...args) : StaticFlowSlot<Indices, Steps>(std::forward<ArgsTuples>(args))... {}
+};
+
+// flow whose steps are fixed at compile time. The run loop is unrolled and every step is called
+// directly (qualified calls, no virtual dispatch, no getType() compares, no dynamic_cast), e.g.
+//   StaticFlow<TitleStep, NumberInputStep, NumberInputStep, CalculusStep, OutputStep> flow("sum",
+//       std::forward_as_tuple("Sum", "of two numbers"), std::forward_as_tuple("a"), std::forward_as_tuple("b"),
+//       std::make_tuple(std::vector<NumberInputStep *>(), std::vector<char>{'+'}, OperationType::Addition),
+//       std::make_tuple(5, "flow.txt", "Sum", "result", std::vector<std::string>()));
+// A CalculusStep built without operands uses the NumberInputSteps that come before it in the flow.
+// A static flow only runs its steps interactively and keeps the in-memory analytics: the run features of
+// ProcessBuilder (memory accounts, deadlines, duplicate detection, output pipeline, analytics store, load
+// generation) are not supported. `proiect_lab --static-demo [file]` runs the example above.
+template <typename... Steps>
+class StaticFlow : private StaticFlowSteps<std::index_sequence_for<Steps...>, Steps...>
+{
+private:
+    static_assert(sizeof...(Steps) > 0, "A static flow needs at least one step");
+
+    template <size_t Index>
+    using StepAt = std::tuple_element_t<Index, std::tuple<Steps...>>;
+
+    std::string flowName;
+    time_t creationTimestamp;
+    FlowAnalytics analytics;
+    std::unique_ptr<PerfCounters> perfCounters;
+    std::vector<std::string> contentFromPreviousSteps;
+
+    template <size_t Index>
+    StepAt<Index> &getStep()
+    {
+        return StaticFlowSlot<Index, StepAt<Index>>::step;
+    }
+
+    template <size_t... Indices>
+    void bindCalculusOperands(std::index_sequence<Indices...>)
+    {
+        std::vector<NumberInputStep *> operands;
+        (bindCalculusOperands<Indices>(operands), ...);
+    }
+
+    template <size_t Index>
+    void bindCalculusOperands(std::vector<NumberInputStep *> &operands)
+    {
+        using T = StepAt<Index>;
+        if constexpr (std::is_same_v<T, NumberInputStep>)
+        {
+            operands.push_back(&getStep<Index>());
+        }
+        else if constexpr (std::is_same_v<T, CalculusStep>)
+        {
+            if (getStep<Index>().getOperandCount() == 0)
+            {
+                getStep<Index>().bindOperands(operands);
+            }
+            operands.clear();
+        }
+    }
+
+    template <size_t... Indices>
+    void runSteps(std::index_sequence<Indices...>)
+    {
+        (runStep<Indices>(), ...);
+    }
+
+    template <size_t Index>
+    void runStep()
+    {
+        using T = StepAt<Index>;
+        T &step = getStep<Index>();
+        std::cout << "Executing step: " << step.T::getType() << std::endl;
+
+        // prompt user to decide if he wants to execute a step or to skip it
+        std::cout << "Do you want to execute this step? (y/n): ";
+        char userChoice;
+        {
+            TraceScope waitScope("wait", "step choice");
+            std::cin >> userChoice;
+        }
+        if (userChoice != 'Y' && userChoice != 'y')
+        {
+            std::cout << "Skipping to the next step..." << std::endl;
+            analytics.recordSkip(step.T::getType());
+            return;
+        }
+
+        {
+            TraceScope stepScope("step", step.T::getType());
+            PerfCounterScope perfScope(perfCounters.get(), analytics, step.T::getType());
+            step.T::execute();
+        }
+
+        if constexpr (std::is_same_v<T, OutputStep>)
+        {
+            step.OutputStep::displayDescription(); // display OUTPUT step details
+            contentFromPreviousSteps.push_back("Content from output step");
+        }
+        else if constexpr (std::is_same_v<T, CalculusStep>)
+        {
+            analytics.addErrorScreens(step.T::getType(), step.getResult());
+        }
+
+        // wait for user confirmation to proceed to the next step
+        std::cout << "Press enter to proceed to the next step...";
+        TraceScope waitScope("wait", "proceed");
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+public:
+    template <typename... ArgsTuples>
+    explicit StaticFlow(const std::string &name, ArgsTuples &&...args)
+        : StaticFlowSteps<std::index_sequence_for<Steps...>, Steps...>(std::forward<ArgsTuples>(args)...), flowName(name), creationTimestamp(time(nullptr))
+    {
+        static_assert(sizeof...(ArgsTuples) == sizeof...(Steps), "Pass one tuple of constructor arguments per step");
+        bindCalculusOperands(std::index_sequence_for<Steps...>{});
+    }
+
+    // the steps keep pointers to each other, so a static flow is never copied
+    StaticFlow(const StaticFlow &) = delete;
+    StaticFlow &operator=(const StaticFlow &) = delete;
+
+    void run()
+    {
+        analytics.recordStart();
+        std::cout << "Running flow '" << flowName << "' created at: " << std::asctime(std::localtime(&creationTimestamp));
+
+        contentFromPreviousSteps.clear();
+        runSteps(std::index_sequence_for<Steps...>{});
+
+        // daca ultimul pas e de tip calculus, afiseaza rezultatul final
+        using LastStep = StepAt<sizeof...(Steps) - 1>;
+        if constexpr (std::is_same_v<LastStep, CalculusStep>)
+        {
+            std::cout << "Final Result: " << formatNumber(getStep<sizeof...(Steps) - 1>().getResult()) << std::endl;
+        }
+
+        analytics.recordCompletion();
+        std::cout << "Flow completed." << std::endl;
+    }
+
+    template <size_t Index>
+    StepAt<Index> &step()
+    {
+        return getStep<Index>();
+    }
+
+    void reportError(const std::string &stepType)
+    {
+        analytics.reportError(stepType);
+    }
+
+    void enablePerfCounters()
+    {
+        perfCounters = std::make_unique<PerfCounters>();
+        analytics.setPerfCountersStatus(true, perfCounters->isAvailable());
+    }
+
+    void displayAnalytics() const
+    {
+        analytics.display(flowName);
+    }
+
+    std::string getFlowName() const
+    {
+        return flowName;
+    }
+};
+
+// builds the steps of a flow from the answers given on std::cin
+void buildFlow(ProcessBuilder &process)
+{
+    process.displayAvailableSteps();
+    std::cout << "Choose one of the following steps: " << endl;
+    std::cout << "1. Title Step" << endl;
+    std::cout << "2. Text Step" << endl;
+    std::cout << "3. Text Input Step" << endl;
+    std::cout << "4. CSV Input Step" << endl;
+    std::cout << "5. Number Input Step" << endl;
+    std::cout << "6. Calculus Step" << endl;
+    std::cout << "7. Display Step" << endl;
+    std::cout << "8. Text File Input Step" << endl;
+    std::cout << "9. CSV File Input Step" << endl;
+    std::cout << "10. Output Step" << endl;
+    std::cout << "11. End Step" << endl;
+    std::cout << "12. Aggregate Step" << endl;
+    std::cout << "13. Lookup Step" << endl;
+    std::cout << "14. Text Search Step" << endl;
+
+    // dynamically add steps to the flow based on user input
+    char addMore;
+    do
+    {
+        addMore = 'n';
+        std::cout << "Enter the type of step to add (TITLE, TEXT, NUMBER, etc.): ";
+        std::string stepType;
+        std::getline(std::cin, stepType);
+
+        if (stepType == "TITLE")
+        {
+            std::string title, subtitle;
+            std::cout << "Enter title: ";
+            std::cin >> title;
+            std::cout << "Enter subtitle: ";
+            std::cin >> subtitle;
+            process.addStep<TitleStep>(title, subtitle);
+        }
+
+        else if (stepType == "TEXT")
+        {
+            std::string title;
             std::string copy;
             std::cout << "Enter title: ";
             std::cin >> title;
@@ -957,184 +7264,1416 @@ int main()
             process.addStep<TextStep>(title, copy);
         }
 
-        else if (stepType == "TEXT INPUT")
+        else if (stepType == "TEXT INPUT")
+        {
+            std::string description;
+            std::cout << "Enter description for text input step: ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+            std::getline(std::cin, description);
+            process.addStep<TextInputStep>(description);
+        }
+
+        else if (stepType == "CSV INPUT")
+        {
+            std::string description;
+            std::cout << "Enter description for CSV INPUT step: ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+            std::getline(std::cin, description);
+            process.addStep<CSVInputStep>(description);
+        }
+
+        else if (stepType == "NUMBER INPUT")
+        {
+            std::string description;
+            std::cout << "Enter a description for number input step: ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
+            std::getline(std::cin, description);
+            process.addStep<NumberInputStep>(description);
+        }
+
+        else if (stepType == "CALCULUS")
+        {
+            std::vector<NumberInputStep *> previousSteps;
+            std::vector<char> operations;
+            std::cout << "Enter the expression ('3 + 4 * 2'): ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::string expression;
+            std::getline(std::cin, expression);
+            // initializam flux de intrare pentru a descompune expresia in token-uri
+            std::istringstream iss(expression);
+            // initializam o variabila pentru a stoca fiecare token din expresie
+            std::string token;
+            // parcurge expresia token cu token
+            while (iss >> token)
+            {
+                // verificam daca tokenul este un operant(numar) sau un operator
+                double operand;
+                if (parseNumber(token, operand))
+                {
+                    std::string description = "Operand" + token;
+                    NumberInputStep *numStep = new NumberInputStep(description, static_cast<float>(operand));
+                    previousSteps.push_back(numStep);
+                }
+                else
+                {
+                    // daca tokenul e operator, il adaugam la vectorul operations
+                    operations.push_back(token[0]);
+                }
+            }
+
+            std::cout << "Choose the operation type: " << std::endl;
+            std::cout << "1. Addition" << std::endl;
+            std::cout << "2. Substraction" << std::endl;
+            std::cout << "3. Multiplication" << std::endl;
+            std::cout << "4. Division" << std::endl;
+            std::cout << "5. Minimum" << std::endl;
+            std::cout << "6. Maximum" << std::endl;
+            int choice;
+            std::cout << "Enter your choice (1-6): ";
+            std::cin >> choice;
+            OperationType opType;
+            switch (choice)
+            {
+            case 1:
+                opType = OperationType::Addition;
+                break;
+            case 2:
+                opType = OperationType::Substraction;
+                break;
+            case 3:
+                opType = OperationType::Multiplication;
+                break;
+            case 4:
+                opType = OperationType::Division;
+                break;
+            case 5:
+                opType = OperationType::Minimum;
+                break;
+            case 6:
+                opType = OperationType::Maximum;
+                break;
+            default:
+                std::cerr << "Invalid choice. Defaulting to addition." << std::endl;
+                opType = OperationType::Addition;
+                break;
+            }
+            // the calculus step owns its operands and frees them
+            process.addStep<CalculusStep>(previousSteps, operations, opType);
+        }
+
+        else if (stepType == "DISPLAY")
+        {
+            std::cout << "Enter the type of of the previous step(TEXT INPUT, CSV INPUT or CSV FILE INPUT): ";
+            std::string prevStepType;
+            std::getline(std::cin, prevStepType);
+            // the step displays the last step of that type added to the flow
+            Step *previousStep = nullptr;
+            if (prevStepType == "TEXT INPUT" || prevStepType == "CSV INPUT" || prevStepType == "CSV FILE INPUT")
+            {
+                previousStep = process.findLastStep(prevStepType);
+            }
+            std::string line;
+            size_t keyColumn = 0;
+            std::string key;
+            if (previousStep && prevStepType == "CSV FILE INPUT")
+            {
+                // with a key only the matching rows are shown, through the index of the column if it has one
+                std::cout << "Enter 'column key' to display only the rows whose column (0-based index) equals the key (empty = all rows): ";
+                std::getline(std::cin, line);
+                std::istringstream(line) >> keyColumn >> key;
+            }
+            if (previousStep && !key.empty())
+            {
+                process.addStep<DisplayStep>(previousStep, keyColumn, key);
+            }
+            else if (previousStep)
+            {
+                process.addStep<DisplayStep>(previousStep);
+                if (prevStepType == "CSV INPUT")
+                {
+                    // the file of a CSV INPUT step can be shown in part, and one page at a time
+                    DisplayStep *display = dynamic_cast<DisplayStep *>(process.findLastStep("DISPLAY"));
+                    uint64_t offset = 0, length = 0, pageBytes = 0;
+                    std::cout << "Enter the part of the file to display as 'offset length' in bytes (empty = the whole file): ";
+                    std::getline(std::cin, line);
+                    std::istringstream(line) >> offset >> length;
+                    std::cout << "Enter the page size in bytes (empty or 0 = no paging): ";
+                    std::getline(std::cin, line);
+                    std::istringstream(line) >> pageBytes;
+                    display->setByteRange(offset, length);
+                    display->setPageSize(pageBytes);
+                }
+            }
+            else
+            {
+                std::cout << "Invalid flow. Display step requires a TEXT INPUT, CSV INPUT or CSV FILE INPUT step before it." << std::endl;
+            }
+        }
+
+        else if (stepType == "TEXT FILE INPUT")
+        {
+            std::string description;
+            std::string fileName;
+            std::string fileContent;
+            std::cout << "Enter a description for this step: ";
+            std::cin >> description;
+            std::cout << "Enter the name of this file: ";
+            std::cin >> fileName;
+            process.addStep<TextFileInputStep>(description, fileName);
+        }
+
+        else if (stepType == "CSV FILE INPUT")
+        {
+            std::string description;
+            std::string file_name;
+            std::cout << "Enter a description for this step: ";
+            std::cin >> description;
+            std::cout << "Enter the name of this file: ";
+            std::cin >> file_name;
+            process.addStep<CSVFileInputStep>(description, file_name);
+
+            char encode;
+            std::cout << "Dictionary encode repeated values? (y/n): ";
+            std::cin >> encode;
+            if (encode == 'y' || encode == 'Y')
+            {
+                dynamic_cast<CSVFileInputStep *>(process.findLastStep("CSV FILE INPUT"))->setDictionaryEncoding(true);
+            }
+        }
+
+        else if (stepType == "OUTPUT")
+        {
+            int stepNumber;
+            std::string fileName;
+            std::string title;
+            std::string description;
+            std::vector<std::string> contentFromPreviousSteps;
+
+            std::cout << "Enter step number for OUTPUT step: ";
+            std::cin >> stepNumber;
+
+            std::cout << "Enter file name for OUTPUT step: ";
+            std::cin >> fileName;
+
+            std::cout << "Enter title for OUTPUT step: ";
+            std::cin >> title;
+
+            std::cout << "Enter description for OUTPUT step: ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::getline(std::cin, description);
+
+            // columnar export: the rows of the last CSV FILE INPUT or AGGREGATE step, in a binary file that
+            // a CSV FILE INPUT step maps back without parsing
+            std::string line;
+            std::cout << "Export the rows of the last CSV FILE INPUT or AGGREGATE step in the columnar format? (c = CSV FILE INPUT, a = AGGREGATE, n = no): ";
+            std::getline(std::cin, line);
+            bool exportTable = !line.empty() && (line[0] == 'c' || line[0] == 'C');
+            bool exportResults = !line.empty() && (line[0] == 'a' || line[0] == 'A');
+            Step *columnarSource = exportTable ? process.findLastStep("CSV FILE INPUT") : (exportResults ? process.findLastStep("AGGREGATE") : nullptr);
+            if (columnarSource)
+            {
+                bool firstRowNames = false;
+                if (exportTable)
+                {
+                    std::cout << "Does the first row contain the column names? (y/n): ";
+                    std::getline(std::cin, line);
+                    firstRowNames = !line.empty() && (line[0] == 'y' || line[0] == 'Y');
+                }
+                process.addStep<OutputStep>(stepNumber, fileName, title, description, columnarSource, firstRowNames);
+            }
+            else
+            {
+                if (exportTable || exportResults)
+                {
+                    std::cout << "No such step before the OUTPUT step, the step writes a text record." << std::endl;
+                }
+                contentFromPreviousSteps.push_back("Content from previous step 1");
+                contentFromPreviousSteps.push_back("Content from previous step 2");
+
+                process.addStep<OutputStep>(stepNumber, fileName, title, description, contentFromPreviousSteps);
+            }
+        }
+
+        else if (stepType == "AGGREGATE")
+        {
+            CSVFileInputStep *source = dynamic_cast<CSVFileInputStep *>(process.findLastStep("CSV FILE INPUT"));
+            if (source)
+            {
+                std::string line;
+                std::vector<size_t> groupColumns;
+                size_t column;
+                std::cout << "Enter the columns to group by (0-based indices separated by spaces): ";
+                std::getline(std::cin, line);
+                std::istringstream columns(line);
+                while (columns >> column)
+                {
+                    groupColumns.push_back(column);
+                }
+
+                size_t valueColumn = 0;
+                std::cout << "Enter the column to aggregate: ";
+                std::getline(std::cin, line);
+                std::istringstream(line) >> valueColumn;
+
+                // filter given as "column operator value", e.g. "2 >= 100"
+                RowFilter filter;
+                std::cout << "Enter a filter ('column operator value', operators = != < <= > >=) or leave empty: ";
+                std::getline(std::cin, line);
+                std::istringstream filterStream(line);
+                std::string op;
+                if (filterStream >> filter.column >> op >> filter.value)
+                {
+                    const std::unordered_map<std::string, FilterOperator> operators = {
+                        {"=", FilterOperator::Equal}, {"!=", FilterOperator::NotEqual}, {"<", FilterOperator::Less}, {"<=", FilterOperator::LessOrEqual}, {">", FilterOperator::Greater}, {">=", FilterOperator::GreaterOrEqual}};
+                    auto found = operators.find(op);
+                    if (found != operators.end())
+                    {
+                        filter.op = found->second;
+                    }
+                    else
+                    {
+                        std::cout << "Unknown operator '" << op << "', the rows are not filtered." << std::endl;
+                    }
+                }
+
+                std::cout << "Does the first row contain the column names? (y/n): ";
+                std::getline(std::cin, line);
+                bool skipHeader = !line.empty() && (line[0] == 'y' || line[0] == 'Y');
+
+                process.addStep<AggregateStep>(source, groupColumns, valueColumn, filter, skipHeader);
+            }
+            else
+            {
+                std::cout << "Invalid flow. Aggregate step requires a CSV FILE INPUT step before it." << std::endl;
+            }
+        }
+
+        else if (stepType == "LOOKUP")
+        {
+            CSVFileInputStep *source = dynamic_cast<CSVFileInputStep *>(process.findLastStep("CSV FILE INPUT"));
+            if (source)
+            {
+                std::string line;
+                size_t column = 0;
+                std::cout << "Enter the column to search (0-based index): ";
+                std::getline(std::cin, line);
+                std::istringstream(line) >> column;
+
+                std::string low, high;
+                std::cout << "Enter the key, or two values 'low high' for a range: ";
+                std::getline(std::cin, line);
+                std::istringstream keys(line);
+                keys >> low;
+                if (!(keys >> high))
+                {
+                    high = low;
+                }
+
+                std::cout << "Index the column? (H = hash index, S = sorted index, anything else = no index): ";
+                std::getline(std::cin, line);
+                if (!line.empty() && (line[0] == 'H' || line[0] == 'h'))
+                {
+                    source->addIndex(IndexKind::Hash, column);
+                }
+                else if (!line.empty() && (line[0] == 'S' || line[0] == 's'))
+                {
+                    source->addIndex(IndexKind::Sorted, column);
+                }
+
+                process.addStep<LookupStep>(source, column, low, high);
+            }
+            else
+            {
+                std::cout << "Invalid flow. Lookup step requires a CSV FILE INPUT step before it." << std::endl;
+            }
+        }
+
+        else if (stepType == "TEXT SEARCH")
+        {
+            TextFileInputStep *source = dynamic_cast<TextFileInputStep *>(process.findLastStep("TEXT FILE INPUT"));
+            if (source)
+            {
+                std::string line;
+                size_t patternCount = 0;
+                std::cout << "Enter the number of patterns to search: ";
+                std::getline(std::cin, line);
+                std::istringstream(line) >> patternCount;
+
+                std::vector<std::string> patterns;
+                for (size_t i = 0; i < patternCount; ++i)
+                {
+                    std::cout << "Enter pattern " << i + 1 << ": ";
+                    std::getline(std::cin, line);
+                    patterns.push_back(line);
+                }
+                process.addStep<TextSearchStep>(source, patterns);
+            }
+            else
+            {
+                std::cout << "Invalid flow. Text search step requires a TEXT FILE INPUT step before it." << std::endl;
+            }
+        }
+
+        else
+        {
+            process.addStep<EndStep>();
+        }
+
+        std::cout << "Do you want to add more steps? (y/n): ";
+        std::cin >> addMore;
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    } while (addMore == 'y' || addMore == 'Y');
+}
+
+// a switch set in the environment: unset, empty, 0, false, off and no turn it off
+bool environmentFlag(const char *name)
+{
+    const char *value = std::getenv(name);
+    if (!value)
+    {
+        return false;
+    }
+    std::string flag(value);
+    std::transform(flag.begin(), flag.end(), flag.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return !(flag.empty() || flag == "0" || flag == "false" || flag == "off" || flag == "no");
+}
+
+// FLOW_MEMORY_BUDGET=<bytes> limits the memory of a flow, FLOW_MEMORY_POLICY=fail makes the steps fail instead
+// of streaming when it is exceeded
+void applyMemoryBudget(ProcessBuilder &process)
+{
+    const char *budget = std::getenv("FLOW_MEMORY_BUDGET");
+    if (!budget)
+    {
+        return;
+    }
+    size_t bytes;
+    if (!parseNumber(budget, bytes))
+    {
+        std::cerr << "Invalid FLOW_MEMORY_BUDGET: " << budget << std::endl;
+        return;
+    }
+    const char *policy = std::getenv("FLOW_MEMORY_POLICY");
+    process.setMemoryBudget(bytes, policy && std::string(policy) == "fail" ? MemoryBudgetPolicy::FailFast : MemoryBudgetPolicy::Stream);
+}
+
+// FLOW_STEP_TIMEOUT=<ms> and FLOW_TIMEOUT=<ms> set the deadlines of every step and of every run;
+// FLOW_TIMEOUT_POLICY=abort stops the run at the first step that times out instead of going on
+void applyTimeouts(ProcessBuilder &process)
+{
+    const char *stepTimeout = std::getenv("FLOW_STEP_TIMEOUT");
+    const char *flowTimeout = std::getenv("FLOW_TIMEOUT");
+    if (!stepTimeout && !flowTimeout)
+    {
+        return;
+    }
+    uint64_t stepMillis = 0, flowMillis = 0;
+    if ((stepTimeout && !parseNumber(stepTimeout, stepMillis)) || (flowTimeout && !parseNumber(flowTimeout, flowMillis)))
+    {
+        std::cerr << "Invalid FLOW_STEP_TIMEOUT or FLOW_TIMEOUT: " << (stepTimeout ? stepTimeout : "") << " " << (flowTimeout ? flowTimeout : "") << std::endl;
+        return;
+    }
+    const char *policy = std::getenv("FLOW_TIMEOUT_POLICY");
+    process.setTimeouts(std::chrono::milliseconds(stepMillis), std::chrono::milliseconds(flowMillis), policy && std::string(policy) == "abort" ? TimeoutPolicy::Abort : TimeoutPolicy::Continue);
+}
+
+// FLOW_DUPLICATES=exact or FLOW_DUPLICATES=bloom[:<expected records>] reports the repeated records of a flow
+void applyDuplicateDetection(ProcessBuilder &process)
+{
+    const char *duplicates = std::getenv("FLOW_DUPLICATES");
+    if (!duplicates)
+    {
+        return;
+    }
+    std::string_view mode(duplicates);
+    if (mode == "exact")
+    {
+        process.enableDuplicateDetection(DuplicateMode::Exact);
+        return;
+    }
+    size_t expectedRecords = 1 << 20;
+    if (mode.substr(0, 5) != "bloom" || (mode.size() > 5 && (mode[5] != ':' || !parseNumber(mode.substr(6), expectedRecords))))
+    {
+        std::cerr << "Invalid FLOW_DUPLICATES: " << duplicates << std::endl;
+        return;
+    }
+    process.enableDuplicateDetection(DuplicateMode::Bloom, expectedRecords);
+}
+
+// binds std::cin, std::cout and std::cerr to other streams for the lifetime of the object
+class StreamRedirect
+{
+private:
+    std::streambuf *oldInput;
+    std::streambuf *oldOutput;
+    std::streambuf *oldError;
+
+public:
+    StreamRedirect(std::istream &input, std::ostream &output)
+        : oldInput(std::cin.rdbuf(input.rdbuf())), oldOutput(std::cout.rdbuf(output.rdbuf())), oldError(std::cerr.rdbuf(output.rdbuf()))
+    {
+        std::cin.clear();
+    }
+
+    StreamRedirect(const StreamRedirect &) = delete;
+    StreamRedirect &operator=(const StreamRedirect &) = delete;
+
+    ~StreamRedirect()
+    {
+        std::cin.rdbuf(oldInput);
+        std::cout.rdbuf(oldOutput);
+        std::cerr.rdbuf(oldError);
+        std::cin.clear();
+    }
+};
+
+// stream buffer that drops everything written to it
+class DiscardBuffer : public std::streambuf
+{
+protected:
+    int overflow(int character) override
+    {
+        return traits_type::not_eof(character);
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+// answers given by the virtual users to the steps of one type: "uniform:<low>:<high>" and
+// "normal:<mean>:<stddev>" draw a number, "a|b|c" picks one of the texts ("\n" in a text starts a new line)
+class InputDistribution
+{
+private:
+    enum class Kind
+    {
+        Uniform,
+        Normal,
+        Choice
+    };
+    Kind kind = Kind::Choice;
+    double first = 0;
+    double second = 0;
+    bool integers = false; // uniform between two integers: draws integers
+    std::vector<std::string> choices;
+
+public:
+    static bool parse(std::string_view spec, InputDistribution &distribution)
+    {
+        size_t colon = spec.find(':');
+        std::string_view name = spec.substr(0, colon);
+        if (colon != std::string_view::npos && (name == "uniform" || name == "normal"))
+        {
+            size_t secondColon = spec.find(':', colon + 1);
+            if (secondColon == std::string_view::npos || !parseNumber(spec.substr(colon + 1, secondColon - colon - 1), distribution.first) || !parseNumber(spec.substr(secondColon + 1), distribution.second))
+            {
+                return false;
+            }
+            distribution.kind = name == "uniform" ? Kind::Uniform : Kind::Normal;
+            distribution.integers = distribution.kind == Kind::Uniform && distribution.first == std::floor(distribution.first) && distribution.second == std::floor(distribution.second);
+            return distribution.kind == Kind::Normal || distribution.first <= distribution.second;
+        }
+
+        distribution.kind = Kind::Choice;
+        distribution.choices.clear();
+        while (true)
+        {
+            size_t bar = spec.find('|');
+            std::string choice;
+            for (size_t i = 0; i < spec.substr(0, bar).size(); ++i)
+            {
+                bool escape = spec[i] == '\\' && i + 1 < spec.size() && spec[i + 1] == 'n';
+                choice += escape ? '\n' : spec[i];
+                i += escape ? 1 : 0;
+            }
+            distribution.choices.push_back(choice);
+            if (bar == std::string_view::npos)
+            {
+                return true;
+            }
+            spec.remove_prefix(bar + 1);
+        }
+    }
+
+    std::string sample(std::mt19937_64 &random) const
+    {
+        switch (kind)
+        {
+        case Kind::Uniform:
+            if (integers)
+            {
+                return formatNumber(std::uniform_int_distribution<int64_t>(static_cast<int64_t>(first), static_cast<int64_t>(second))(random));
+            }
+            return formatNumber(std::uniform_real_distribution<double>(first, second)(random));
+        case Kind::Normal:
+            return formatNumber(std::normal_distribution<double>(first, second)(random));
+        default:
+            return choices[std::uniform_int_distribution<size_t>(0, choices.size() - 1)(random)];
+        }
+    }
+};
+
+struct LoadOptions
+{
+    size_t users = 1;
+    size_t runs = 100;          // total number of runs, unless durationSeconds is set
+    double durationSeconds = 0; // when set, runs start until this much time has passed
+    double thinkMillis = 0;     // mean think time before each step, exponentially distributed
+    double skipProbability = 0; // chance of skipping each step
+    bool openLoop = false;      // runs arrive at arrivalRate whether or not the previous ones have finished
+    double arrivalRate = 10;    // runs per second of the open loop
+    uint64_t seed = 1;
+    std::unordered_map<std::string, InputDistribution> inputs; // by step type, empty answers for the others
+};
+
+// drives virtual users through a flow to measure its throughput and latencies. Each user is a thread that
+// answers the run like a person at the terminal would: it thinks before each step, skips some steps and
+// draws the input of the others from a distribution. The steps talk to std::cin and std::cout, so like the
+// requests of the flow server, the steps of all the users execute one at a time: a user holds the streams
+// lock for its whole run except while thinking. The latency of a step thus includes the time spent waiting
+// for the other users, which is what a host running the flows for that many users would show
+class LoadGenerator
+{
+private:
+    struct StepStats
+    {
+        size_t skips = 0;
+        double serviceSeconds = 0;    // time spent executing the step
+        std::vector<double> latencies; // seconds from the end of the think time to the end of the step
+    };
+
+    ProcessBuilder &process;
+    const LoadOptions &options;
+
+    std::mutex streamsMutex; // held by the user whose run is bound to the streams
+    std::vector<StepStats> stepStats;
+    std::vector<double> runLatencies;
+    size_t failedRuns = 0;
+
+    // start of the runs: the next arrival time in open loop, the number of runs started in closed loop
+    std::mutex scheduleMutex;
+    std::mt19937_64 arrivalRandom;
+    std::chrono::steady_clock::time_point nextArrival;
+    std::chrono::steady_clock::time_point deadline;
+    size_t startedRuns = 0;
+
+    class VirtualUser : public RunDriver
+    {
+    private:
+        LoadGenerator &generator;
+        std::mt19937_64 random;
+        std::unique_lock<std::mutex> streamsLock;
+        DiscardBuffer discardBuffer;
+        std::ostream discard;
+        std::istringstream noInput;
+        std::optional<StreamRedirect> redirect;
+        std::chrono::steady_clock::time_point readyAt; // when the user finished thinking
+
+        void acquire()
+        {
+            streamsLock.lock();
+            redirect.emplace(noInput, discard);
+        }
+
+        void release()
+        {
+            redirect.reset();
+            streamsLock.unlock();
+        }
+
+    public:
+        VirtualUser(LoadGenerator &generator, uint64_t seed) : generator(generator), random(seed), streamsLock(generator.streamsMutex, std::defer_lock), discard(&discardBuffer) {}
+
+        bool chooseStep(size_t index, const Step &) override
+        {
+            if (generator.options.thinkMillis > 0)
+            {
+                release();
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(std::exponential_distribution<double>(1.0 / generator.options.thinkMillis)(random)));
+                readyAt = std::chrono::steady_clock::now();
+                acquire();
+            }
+            if (std::uniform_real_distribution<double>(0, 1)(random) < generator.options.skipProbability)
+            {
+                generator.stepStats[index].skips++;
+                return false;
+            }
+            return true;
+        }
+
+        void executeStep(size_t index, const Step &step, const std::function<void()> &execute) override
+        {
+            // the input starts with the end of the line of the "execute this step?" answer, which the steps skip
+            auto distribution = generator.options.inputs.find(step.getType());
+            std::istringstream input("\n" + (distribution != generator.options.inputs.end() ? distribution->second.sample(random) : std::string()) + "\n");
+            StreamRedirect stepRedirect(input, discard);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            // a step that fails (or times out) still counts, with the time it took to fail
+            auto record = [this, index, start]()
+            {
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                StepStats &stats = generator.stepStats[index];
+                stats.serviceSeconds += std::chrono::duration<double>(end - start).count();
+                stats.latencies.push_back(std::chrono::duration<double>(end - readyAt).count());
+                readyAt = end;
+            };
+            try
+            {
+                execute();
+            }
+            catch (...)
+            {
+                record();
+                throw;
+            }
+            record();
+        }
+
+        // one run that should have started at arrival
+        void run(std::chrono::steady_clock::time_point arrival)
+        {
+            readyAt = std::chrono::steady_clock::now();
+            acquire();
+            try
+            {
+                if (!generator.process.runFlow(this))
+                {
+                    generator.failedRuns++;
+                }
+            }
+            catch (const std::exception &)
+            {
+                generator.process.reportError("RUN");
+                generator.failedRuns++;
+            }
+            generator.runLatencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - arrival).count());
+            release();
+        }
+    };
+
+    // the time at which the next run should start, false once all the runs have started
+    bool nextRun(std::chrono::steady_clock::time_point &arrival)
+    {
+        std::lock_guard<std::mutex> lock(scheduleMutex);
+        arrival = options.openLoop ? nextArrival : std::chrono::steady_clock::now();
+        if (options.durationSeconds > 0 ? arrival >= deadline : startedRuns >= options.runs)
+        {
+            return false;
+        }
+        startedRuns++;
+        if (options.openLoop)
+        {
+            nextArrival += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::exponential_distribution<double>(options.arrivalRate)(arrivalRandom)));
+        }
+        return true;
+    }
+
+    // nearest rank percentile of sorted values, in milliseconds
+    static double percentileMillis(const std::vector<double> &sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[rank > 0 ? rank - 1 : 0] * 1000;
+    }
+
+    static void displayLatencies(std::vector<double> &latencies)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << "p50 " << percentileMillis(latencies, 0.5) << " ms, p90 " << percentileMillis(latencies, 0.9)
+                  << " ms, p99 " << percentileMillis(latencies, 0.99) << " ms, max " << percentileMillis(latencies, 1.0) << " ms";
+    }
+
+public:
+    LoadGenerator(ProcessBuilder &process, const LoadOptions &options) : process(process), options(options), arrivalRandom(options.seed) {}
+
+    void run()
+    {
+        stepStats.assign(process.getStepCount(), StepStats());
+        runLatencies.clear();
+        failedRuns = 0;
+        startedRuns = 0;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        nextArrival = start;
+        deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+        std::vector<std::thread> users;
+        for (size_t i = 0; i < options.users; ++i)
+        {
+            users.emplace_back([this, i]()
+                               {
+                                   VirtualUser user(*this, options.seed + 1 + i);
+                                   std::chrono::steady_clock::time_point arrival;
+                                   while (nextRun(arrival))
+                                   {
+                                       std::this_thread::sleep_until(arrival);
+                                       user.run(arrival);
+                                   } });
+        }
+        for (std::thread &user : users)
+        {
+            user.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Load test of flow '" << process.getFlowName() << "': " << options.users << " virtual users, "
+                  << (options.openLoop ? "open loop" : "closed loop") << ", " << runLatencies.size() << " runs in " << elapsed << " s" << std::endl;
+        std::cout << "Throughput: " << runLatencies.size() / elapsed << " runs/s (" << runLatencies.size() - failedRuns << " completed, " << failedRuns << " failed)" << std::endl;
+        std::cout << "Run latency: ";
+        displayLatencies(runLatencies);
+        std::cout << std::endl;
+        std::cout << "Step latency, from the end of the think time to the end of the step:" << std::endl;
+        for (size_t i = 0; i < stepStats.size(); ++i)
+        {
+            StepStats &stats = stepStats[i];
+            size_t executions = stats.latencies.size();
+            if (executions == 0 && stats.skips == 0)
+            {
+                std::cout << "Step " << i + 1 << " " << process.getStepType(i) << ": not executed" << std::endl;
+                continue;
+            }
+            std::cout << "Step " << i + 1 << " " << process.getStepType(i) << ": " << executions << " executions, " << stats.skips << " skips, "
+                      << executions / elapsed << "/s, ";
+            displayLatencies(stats.latencies);
+            std::cout << ", mean service " << (executions > 0 ? stats.serviceSeconds * 1000 / executions : 0.0) << " ms" << std::endl;
+        }
+        std::cout << std::defaultfloat;
+    }
+};
+
+#ifdef __linux__
+// long-running server that keeps flow definitions, their steps (with loaded files and indexes) and their
+// analytics in memory between runs. Clients connect to a Unix domain socket and exchange frames made of
+// a 4-byte big-endian payload length, one type byte and the payload. Requests carry "flowName\n" + input:
+//   'D' defines (or redefines) a flow, the input holds the answers of the step builder dialog
+//   'R' runs a flow, the input holds the answers of the run (y/n choices, numbers, texts...)
+//   'A' displays the analytics of a flow
+//   'X' deletes a flow
+// Every request gets one reply frame: 'O' with the output of the request or 'E' with an error.
+// The steps talk to std::cin and std::cout, so requests execute one at a time with the streams bound to
+// the request, while an epoll loop multiplexes the connections of all the clients around them.
+class FlowServer
+{
+private:
+    struct ClientSession
+    {
+        std::string input;  // bytes received and not yet parsed into frames
+        std::string output; // reply bytes not yet written
+    };
+
+    std::string socketPath;
+    int listenFd;
+    int epollFd;
+    std::unordered_map<std::string, std::unique_ptr<ProcessBuilder>> flows;
+    std::unordered_map<int, ClientSession> sessions;
+    OutputPipeline *outputPipeline; // shared by all the flows, may be null
+
+    static const uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;
+    static inline volatile std::sig_atomic_t stopRequested = 0;
+
+    static void requestStop(int)
+    {
+        stopRequested = 1;
+    }
+
+    void closeSession(int fd)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        sessions.erase(fd);
+    }
+
+    void acceptClients()
+    {
+        while (true)
+        {
+            int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (clientFd < 0)
+            {
+                return; // EAGAIN: no more pending connections
+            }
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = clientFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &event);
+            sessions[clientFd];
+        }
+    }
+
+    // writes as much pending output as the socket accepts, returns false when the connection is broken
+    bool flushSession(int fd, ClientSession &session)
+    {
+        size_t written = 0;
+        while (written < session.output.size())
+        {
+            ssize_t count = send(fd, session.output.data() + written, session.output.size() - written, MSG_NOSIGNAL);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    return false;
+                }
+                break;
+            }
+            written += static_cast<size_t>(count);
+        }
+        session.output.erase(0, written);
+
+        // wait for the socket to become writable only while output is pending
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP | (session.output.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+        return true;
+    }
+
+    void handleClient(int fd, uint32_t events)
+    {
+        ClientSession &session = sessions[fd];
+        bool peerClosed = (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+        if (events & EPOLLIN)
+        {
+            char buffer[64 * 1024];
+            while (true)
+            {
+                ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+                if (count > 0)
+                {
+                    session.input.append(buffer, static_cast<size_t>(count));
+                    continue;
+                }
+                if (count == 0)
+                {
+                    peerClosed = true;
+                }
+                else if (errno == EINTR)
+                {
+                    continue;
+                }
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    peerClosed = true;
+                }
+                break;
+            }
+
+            char type;
+            std::string payload;
+            bool tooLarge = false;
+            while (takeFrame(session.input, type, payload, tooLarge))
+            {
+                std::pair<char, std::string> reply = handleRequest(type, payload);
+                appendFrame(session.output, reply.first, reply.second);
+            }
+            if (tooLarge)
+            {
+                appendFrame(session.output, 'E', "Frame too large");
+                flushSession(fd, session);
+                closeSession(fd);
+                return;
+            }
+        }
+
+        if (!flushSession(fd, session) || (peerClosed && session.output.empty()))
+        {
+            closeSession(fd);
+        }
+    }
+
+    std::pair<char, std::string> handleRequest(char type, const std::string &payload)
+    {
+        size_t newline = payload.find('\n');
+        std::string flowName = payload.substr(0, newline);
+        std::istringstream input(newline == std::string::npos ? std::string() : payload.substr(newline + 1));
+        std::ostringstream output;
+
+        auto found = flows.find(flowName);
+        if (type != 'D' && found == flows.end())
+        {
+            return {'E', "Error!!! Flow '" + flowName + "' not found\n"};
+        }
+
+        StreamRedirect redirect(input, output);
+        try
+        {
+            switch (type)
+            {
+            case 'D':
+            {
+                auto process = std::make_unique<ProcessBuilder>();
+                process->setFlowName(flowName);
+                if (environmentFlag("FLOW_PERF_COUNTERS"))
+                {
+                    process->enablePerfCounters();
+                }
+                applyMemoryBudget(*process);
+                applyDuplicateDetection(*process);
+                applyTimeouts(*process);
+                if (const char *analyticsFile = std::getenv("FLOW_ANALYTICS_STORE"))
+                {
+                    process->setAnalyticsStore(analyticsFile);
+                }
+                buildFlow(*process);
+                process->setOutputPipeline(outputPipeline);
+                for (const auto &flow : flows)
+                {
+                    if (flow.first != flowName && flow.second->fingerprint() == process->fingerprint())
+                    {
+                        std::cout << "Flow '" << flowName << "' has the same steps as flow '" << flow.first << "'" << std::endl;
+                    }
+                }
+                flows[flowName] = std::move(process);
+                break;
+            }
+            case 'R':
+                found->second->runFlow();
+                break;
+            case 'A':
+                found->second->displayAnalytics();
+                break;
+            case 'X':
+                flows.erase(found);
+                std::cout << "Flow '" << flowName << "' deleted" << std::endl;
+                break;
+            default:
+                return {'E', std::string("Unknown request type '") + type + "'\n"};
+            }
+        }
+        catch (const std::exception &error)
+        {
+            if (type == 'R')
+            {
+                found->second->reportError("RUN");
+            }
+            return {'E', output.str() + "\nError: " + error.what() + "\n"};
+        }
+        return {'O', output.str()};
+    }
+
+public:
+    FlowServer(const std::string &socketPath, OutputPipeline *outputPipeline) : socketPath(socketPath), listenFd(-1), epollFd(-1), outputPipeline(outputPipeline) {}
+
+    FlowServer(const FlowServer &) = delete;
+    FlowServer &operator=(const FlowServer &) = delete;
+
+    ~FlowServer()
+    {
+        for (const auto &session : sessions)
         {
-            std::string description;
-            std::cout << "Enter description for text input step: ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-            std::getline(std::cin, description);
-            process.addStep<TextInputStep>(description);
+            close(session.first);
+        }
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+        if (epollFd >= 0)
+        {
+            close(epollFd);
         }
+    }
 
-        else if (stepType == "CSV INPUT")
+    static void appendFrame(std::string &buffer, char type, const std::string &payload)
+    {
+        uint32_t length = static_cast<uint32_t>(payload.size());
+        char header[5] = {static_cast<char>(length >> 24), static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length), type};
+        buffer.append(header, sizeof(header));
+        buffer.append(payload);
+    }
+
+    // removes the first complete frame from the buffer; tooLarge is set for frames over the size limit
+    static bool takeFrame(std::string &buffer, char &type, std::string &payload, bool &tooLarge)
+    {
+        if (buffer.size() < 5)
         {
-            std::string description;
-            std::cout << "Enter description for CSV INPUT step: ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-            std::getline(std::cin, description);
-            process.addStep<CSVInputStep>(description);
+            return false;
+        }
+        const unsigned char *header = reinterpret_cast<const unsigned char *>(buffer.data());
+        uint32_t length = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) | (uint32_t(header[2]) << 8) | uint32_t(header[3]);
+        if (length > MAX_FRAME_SIZE)
+        {
+            tooLarge = true;
+            return false;
+        }
+        if (buffer.size() < 5 + static_cast<size_t>(length))
+        {
+            return false;
         }
+        type = buffer[4];
+        payload.assign(buffer, 5, length);
+        buffer.erase(0, 5 + static_cast<size_t>(length));
+        return true;
+    }
 
-        else if (stepType == "NUMBER INPUT")
+    bool start()
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
         {
-            std::string description;
-            std::cout << "Enter a description for number input step: ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear the input buffer
-            std::getline(std::cin, description);
-            process.addStep<NumberInputStep>(description);
+            std::cerr << "Error: Socket path '" << socketPath << "' is too long." << std::endl;
+            return false;
         }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
 
-        else if (stepType == "CALCULUS")
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(socketPath.c_str());
+        if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listenFd, SOMAXCONN) < 0)
         {
-            std::vector<NumberInputStep *> previousSteps;
-            std::vector<char> operations;
-            std::cout << "Enter the expression ('3 + 4 * 2'): ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::string expression;
-            std::getline(std::cin, expression);
-            // initializam flux de intrare pentru a descompune expresia in token-uri
-            std::istringstream iss(expression);
-            // initializam o variabila pentru a stoca fiecare token din expresie
-            std::string token;
-            // parcurge expresia token cu token
-            while (iss >> token)
+            std::cerr << "Error: Unable to listen on '" << socketPath << "': " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0)
+        {
+            std::cerr << "Error: Unable to create the event loop: " << strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // serves the clients until SIGINT or SIGTERM
+    void run()
+    {
+        struct sigaction action{};
+        action.sa_handler = requestStop;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+
+        std::cout << "Serving flows on '" << socketPath << "'" << std::endl;
+        epoll_event events[64];
+        while (!stopRequested)
+        {
+            int count = epoll_wait(epollFd, events, 64, -1);
+            if (count < 0)
             {
-                // verificam daca tokenul este un operant(numar) sau un operator
-                if (isdigit(token[0]) || (token[0] == '-' && isdigit(token[1])))
+                if (errno == EINTR)
                 {
-                    std::string description = "Operand" + token;
-                    NumberInputStep *numStep = new NumberInputStep(description);
-                    previousSteps.push_back(numStep);
+                    continue;
                 }
-                else
+                std::cerr << "Error: epoll_wait failed: " << strerror(errno) << std::endl;
+                break;
+            }
+            for (int i = 0; i < count; ++i)
+            {
+                if (events[i].data.fd == listenFd)
                 {
-                    // daca tokenul e operator, il adaugam la vectorul operations
-                    operations.push_back(token[0]);
+                    acceptClients();
+                }
+                else if (sessions.count(events[i].data.fd))
+                {
+                    handleClient(events[i].data.fd, events[i].events);
                 }
             }
+        }
+        std::cout << "Server stopped" << std::endl;
+    }
 
-            std::cout << "Choose the operation type: " << std::endl;
-            std::cout << "1. Addition" << std::endl;
-            std::cout << "2. Substraction" << std::endl;
-            std::cout << "3. Multiplication" << std::endl;
-            std::cout << "4. Division" << std::endl;
-            std::cout << "5. Minimum" << std::endl;
-            std::cout << "6. Maximum" << std::endl;
-            int choice;
-            std::cout << "Enter your choice (1-6): ";
-            std::cin >> choice;
-            OperationType opType;
-            switch (choice)
+    // sends one request with the standard input as its input and prints the reply
+    static int runClient(const std::string &socketPath, char type, const std::string &flowName)
+    {
+        std::string payload = flowName + "\n";
+        if (type == 'D' || type == 'R')
+        {
+            payload.append(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        }
+        std::string request;
+        appendFrame(request, type, payload);
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            std::cerr << "Error: Unable to connect to '" << socketPath << "': " << strerror(errno) << std::endl;
+            if (fd >= 0)
             {
-            case 1:
-                opType = OperationType::Addition;
-                break;
-            case 2:
-                opType = OperationType::Substraction;
-                break;
-            case 3:
-                opType = OperationType::Multiplication;
-                break;
-            case 4:
-                opType = OperationType::Division;
-                break;
-            case 5:
-                opType = OperationType::Minimum;
-                break;
-            case 6:
-                opType = OperationType::Maximum;
-                break;
-            default:
-                std::cerr << "Invalid choice. Defaulting to addition." << std::endl;
-                opType = OperationType::Addition;
-                break;
+                close(fd);
             }
-            process.addStep<CalculusStep>(previousSteps, operations, opType);
+            return 1;
+        }
 
-            for (NumberInputStep *numStep : previousSteps)
+        for (size_t written = 0; written < request.size();)
+        {
+            ssize_t count = send(fd, request.data() + written, request.size() - written, MSG_NOSIGNAL);
+            if (count <= 0)
             {
-                delete numStep;
+                std::cerr << "Error: Unable to send the request." << std::endl;
+                close(fd);
+                return 1;
             }
+            written += static_cast<size_t>(count);
         }
 
-        else if (stepType == "DISPLAY")
+        std::string reply;
+        char replyType = 'E';
+        std::string replyPayload;
+        bool tooLarge = false;
+        char buffer[64 * 1024];
+        while (!takeFrame(reply, replyType, replyPayload, tooLarge))
         {
-            std::cout << "Enter the type of of the previous step(TEXT INPUT, CVS INPUT etc.)";
-            std::string prevStepType;
-            std::cin >> prevStepType;
-            if (prevStepType == "TEXT INPUT" || prevStepType == "CSV INPUT")
+            ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0 || tooLarge)
+            {
+                std::cerr << "Error: Connection closed before the reply." << std::endl;
+                close(fd);
+                return 1;
+            }
+            reply.append(buffer, static_cast<size_t>(count));
+        }
+        close(fd);
+
+        (replyType == 'O' ? std::cout : std::cerr) << replyPayload;
+        return replyType == 'O' ? 0 : 1;
+    }
+};
+#endif
+
+int main(int argc, char *argv[])
+{
+    // FLOW_TRACE=<file.json> records a Chrome trace-event file of the run
+    const char *traceFile = std::getenv("FLOW_TRACE");
+    if (traceFile)
+    {
+        Tracer::enable();
+    }
+
+    // FLOW_OUTPUT_SINKS=stdout,file:<name>,rotate:<name>:<max bytes>:<max files> sends the output records to these sinks
+    OutputPipeline outputPipeline;
+    const char *outputSinks = std::getenv("FLOW_OUTPUT_SINKS");
+    if (outputSinks && !OutputPipeline::addSinks(outputPipeline, outputSinks))
+    {
+        return 1;
+    }
+    OutputPipeline *pipeline = outputPipeline.hasSinks() ? &outputPipeline : nullptr;
+    if (argc >= 2 && (std::string(argv[1]) == "--serve" || std::string(argv[1]) == "--load") && outputPipeline.writesToStdout())
+    {
+        // their flows write to std::cout bound to a client or discarded, the sink would write to this terminal
+        std::cerr << "Error: The stdout output sink cannot be used with " << argv[1] << ", use a file sink instead." << std::endl;
+        return 1;
+    }
+
+    // --analytics <file> [--flow <name>] [--from <epoch seconds>] [--to <epoch seconds>] [--bucket minute|hour|day]
+    // summarizes the runs recorded with FLOW_ANALYTICS_STORE
+    if (argc >= 3 && std::string(argv[1]) == "--analytics")
+    {
+        std::string flowFilter;
+        int64_t fromSeconds = 0;
+        int64_t toSeconds = std::numeric_limits<int64_t>::max();
+        int64_t bucketSeconds = 3600;
+        for (int i = 3; i + 1 < argc; i += 2)
+        {
+            std::string option = argv[i];
+            std::string value = argv[i + 1];
+            bool valid = true;
+            if (option == "--flow")
+            {
+                flowFilter = value;
+            }
+            else if (option == "--from")
+            {
+                valid = parseNumber(value, fromSeconds);
+            }
+            else if (option == "--to")
+            {
+                valid = parseNumber(value, toSeconds);
+            }
+            else if (option == "--bucket")
             {
-                // Creează un pas fictiv de tipul specificat de utilizator pentru a servi drept pas anterior în cadrul demonstrației.
-                // Este folosit static_cast pentru a converti instanța de TextInputStep sau CSVInputStep într-un pointer la clasa de bază Step.
-                Step *dummyPrevStep = (prevStepType == "TEXT INPUT") ? static_cast<Step *>(new TextInputStep("")) : static_cast<Step *>(new CSVInputStep(""));
-                process.addStep<DisplayStep>(dummyPrevStep);
+                bucketSeconds = value == "minute" ? 60 : (value == "hour" ? 3600 : (value == "day" ? 86400 : 0));
+                valid = bucketSeconds > 0;
             }
             else
             {
-                std::cout << "Invalid previous step type. Display step requires TEXT INPUT or CSV INPUT." << std::endl;
+                valid = false;
+            }
+            if (!valid)
+            {
+                std::cerr << "Invalid option: " << option << " " << value << std::endl;
+                return 1;
             }
         }
+        return AnalyticsStore(argv[2]).query(flowFilter, fromSeconds, toSeconds, bucketSeconds) ? 0 : 1;
+    }
 
-        else if (stepType == "TEXT FILE INPUT")
+    // --load <script> [--users <n>] [--runs <n>] [--duration <seconds>] [--think <mean ms>] [--skip <probability>]
+    //        [--arrival closed|open] [--rate <runs per second>] [--input "<STEP TYPE>=<distribution>"] [--seed <n>]
+    // builds the flow from the script (the answers of an interactive session, up to the first run) and runs it
+    // for virtual users, see LoadGenerator
+    if (argc >= 3 && std::string(argv[1]) == "--load")
+    {
+        LoadOptions options;
+        for (int i = 3; i + 1 < argc; i += 2)
         {
-            std::string description;
-            std::string fileName;
-            std::string fileContent;
-            std::cout << "Enter a description for this step: ";
-            std::cin >> description;
-            std::cout << "Enter the name of this file: ";
-            std::cout << fileName;
-            process.addStep<TextFileInputStep>(description, fileName);
+            std::string option = argv[i];
+            std::string value = argv[i + 1];
+            bool valid = true;
+            if (option == "--users")
+            {
+                valid = parseNumber(value, options.users) && options.users > 0;
+            }
+            else if (option == "--runs")
+            {
+                valid = parseNumber(value, options.runs);
+            }
+            else if (option == "--duration")
+            {
+                valid = parseNumber(value, options.durationSeconds) && options.durationSeconds > 0;
+            }
+            else if (option == "--think")
+            {
+                valid = parseNumber(value, options.thinkMillis) && options.thinkMillis >= 0;
+            }
+            else if (option == "--skip")
+            {
+                valid = parseNumber(value, options.skipProbability) && options.skipProbability >= 0 && options.skipProbability <= 1;
+            }
+            else if (option == "--arrival")
+            {
+                options.openLoop = value == "open";
+                valid = value == "open" || value == "closed";
+            }
+            else if (option == "--rate")
+            {
+                valid = parseNumber(value, options.arrivalRate) && options.arrivalRate > 0;
+            }
+            else if (option == "--input")
+            {
+                size_t equals = value.find('=');
+                valid = equals != std::string::npos && InputDistribution::parse(std::string_view(value).substr(equals + 1), options.inputs[value.substr(0, equals)]);
+            }
+            else if (option == "--seed")
+            {
+                valid = parseNumber(value, options.seed);
+            }
+            else
+            {
+                valid = false;
+            }
+            if (!valid)
+            {
+                std::cerr << "Invalid option: " << option << " " << value << std::endl;
+                return 1;
+            }
         }
 
-        else if (stepType == "CSV FILE INPUT")
+        std::ifstream scriptFile(argv[2]);
+        if (!scriptFile.is_open())
         {
-            std::string description;
-            std::string file_name;
-            std::cout << "Enter a description for this step: ";
-            std::cin >> description;
-            std::cout << "Enter the name of this file: ";
-            std::cin >> file_name;
-            process.addStep<CSVFileInputStep>(description, file_name);
+            std::cerr << "Unable to open the file: " << argv[2] << std::endl;
+            return 1;
         }
-
-        else if (stepType == "OUTPUT")
+        ProcessBuilder process;
+        applyMemoryBudget(process);
+        applyDuplicateDetection(process);
+        applyTimeouts(process);
+        if (const char *analyticsFile = std::getenv("FLOW_ANALYTICS_STORE"))
         {
-            int stepNumber;
-            std::string fileName;
-            std::string title;
-            std::string description;
-            std::vector<std::string> contentFromPreviousSteps;
-
-            std::cout << "Enter step number for OUTPUT step: ";
-            std::cin >> stepNumber;
-
-            std::cout << "Enter file name for OUTPUT step: ";
-            std::cin >> fileName;
-
-            std::cout << "Enter title for OUTPUT step: ";
-            std::cin >> title;
-
-            std::cout << "Enter description for OUTPUT step: ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::getline(std::cin, description);
+            process.setAnalyticsStore(analyticsFile);
+        }
+        {
+            std::ostringstream dialog;
+            StreamRedirect redirect(scriptFile, dialog);
+            std::string flowName;
+            std::getline(std::cin, flowName);
+            process.setFlowName(flowName);
+            buildFlow(process);
+        }
+        process.setOutputPipeline(pipeline);
 
-            contentFromPreviousSteps.push_back("Content from previous step 1");
-            contentFromPreviousSteps.push_back("Content from previous step 2");
+        LoadGenerator(process, options).run();
+        process.displayAnalytics();
+        outputPipeline.close();
+        if (traceFile)
+        {
+            Tracer::flush(traceFile);
+        }
+        return 0;
+    }
 
-            process.addStep<OutputStep>(stepNumber, fileName, title, description, contentFromPreviousSteps);
+    // --static-demo [file] runs the example flow of StaticFlow, a sum of two numbers written to the file
+    // (static_demo.txt in the temporary directory by default, so no file of the working directory is replaced)
+    if (argc >= 2 && std::string(argv[1]) == "--static-demo")
+    {
+        std::string outputFile = argc >= 3 ? argv[2] : (std::filesystem::temp_directory_path() / "static_demo.txt").string();
+        StaticFlow<TitleStep, NumberInputStep, NumberInputStep, CalculusStep, OutputStep> flow("sum",
+            std::forward_as_tuple("Sum", "of two numbers"), std::forward_as_tuple("a"), std::forward_as_tuple("b"),
+            std::make_tuple(std::vector<NumberInputStep *>(), std::vector<char>{'+'}, OperationType::Addition),
+            std::make_tuple(5, outputFile, "Sum", "result", std::vector<std::string>()));
+        flow.run();
+        flow.displayAnalytics();
+        if (traceFile)
+        {
+            Tracer::flush(traceFile);
         }
+        return 0;
+    }
 
-        else
+#ifdef __linux__
+    // --serve <socket> keeps flows in memory and serves them, --client <socket> <D|R|A|X> <flow> sends one request
+    if (argc >= 3 && std::string(argv[1]) == "--serve")
+    {
+        FlowServer server(argv[2], pipeline);
+        if (!server.start())
         {
-            process.addStep<EndStep>();
+            return 1;
+        }
+        server.run();
+        outputPipeline.close();
+        if (traceFile)
+        {
+            Tracer::flush(traceFile);
         }
+        return 0;
+    }
+    if (argc >= 5 && std::string(argv[1]) == "--client")
+    {
+        return FlowServer::runClient(argv[2], argv[3][0], argv[4]);
+    }
+#else
+    (void)argc;
+    (void)argv;
+#endif
 
-        std::cout << "Do you want to add more steps? (y/n): ";
-        std::cin >> addMore;
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    ProcessBuilder process;
+    // FLOW_PERF_COUNTERS=1 samples hardware counters around every step
+    if (environmentFlag("FLOW_PERF_COUNTERS"))
+    {
+        process.enablePerfCounters();
+    }
+    applyMemoryBudget(process);
+    applyDuplicateDetection(process);
+    applyTimeouts(process);
+    // FLOW_ANALYTICS_STORE=<file> records every run for --analytics queries
+    if (const char *analyticsFile = std::getenv("FLOW_ANALYTICS_STORE"))
+    {
+        process.setAnalyticsStore(analyticsFile);
+    }
 
-    } while (addMore == 'y' || addMore == 'Y');
+    std::string flowName;
+    std::cout << "Enter the name for your flow: ";
+    std::getline(std::cin, flowName);
+    process.setFlowName(flowName);
+
+    buildFlow(process);
+    process.setOutputPipeline(pipeline);
 
     std::string fileName = "flow.txt";
     std::string file_name = "flow.csv";
@@ -1144,6 +8683,12 @@ int main()
     // Get and display the creation timestamp
     std::cout << "Flow '" << flowName << "' created at: " << process.getCreationTimestamp() << std::endl;
     process.displayAnalytics();
+    outputPipeline.close();
+
+    if (traceFile)
+    {
+        Tracer::flush(traceFile);
+    }
 
     try
     {